@@ -0,0 +1,670 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "GoL_kernels.h"
+
+#include <immintrin.h>  //vector intrinsic
+
+// The kernels in this file evolve a single row of a grid that uses the encoding of static_evolution:
+// the state of a cell is stored in alternating positions between bit 1 and bit 2 of a char
+// ("current" is the bit of the state in this generation, "next" is the bit of the following one).
+// The row is updated in place: the "current" bit is preserved and the "next" bit is set to the new state.
+// The three rows are read only once, and each block of cells is completed (neighbours, rule and store)
+// before moving to the following one. The first and last cells of the row are neighbours (torus).
+//
+// Each vector version is compiled for its own instruction set (target attribute), so the file doesn't need
+// -march=native and the same binary can run on any x86 node. The version to use is chosen at runtime
+// with CPUID by select_static_kernel (or forced by name), and static_evolve_row calls it through a pointer.
+//
+// The rule (Life-like, B.../S...) is chosen with set_rule. The kernels are generated from GoL_kernels_template.h
+// for each of the common rules (Conway, HighLife, Day & Night) with the masks of the rule as constants, and
+// once more with the masks read at runtime for all the other rules.
+//
+// static_evolve_padded_row works on the rows of a halo grid (GoL_parallel_grid.c), which have the ghost columns:
+// without the wrap on the columns its kernel is a plain loop, and it's vectorised by the compiler.
+//
+// ordered_flip_mask is not a row kernel: it scans the cells of ordered_evolution for the ones that can change state,
+// with the same versions (the scalar, lookup and sse2 versions use a table, pshufb needs SSSE3).
+
+// The rule of the evolution (Life-like): bit n of rule_birth is set if a dead cell with n neighbours is born,
+// bit n of rule_survive is set if a live cell with n neighbours survives. The default is B3/S23.
+unsigned int rule_birth = RULE_CONWAY_BIRTH;
+unsigned int rule_survive = RULE_CONWAY_SURVIVE;
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+// Evaluation of the rule for a single cell and for a vector of cells (given the sum of the neighbours, nei*current,
+// and the cells that are alive). They are always inlined, so with constant masks only the needed comparisons remain.
+
+static inline __attribute__((always_inline)) unsigned char rule_scalar(unsigned char my_current, unsigned char nei, unsigned int birth, unsigned int survive){
+	return (((my_current) ? survive : birth) >> nei) & 1;
+}
+
+__attribute__((target("sse2")))
+static inline __attribute__((always_inline)) __m128i rule_sse2(__m128i sum, __m128i mine_alive, unsigned char current, unsigned int birth, unsigned int survive){
+
+	// The values of nei in both masks make the cell alive, the others only if it's dead (birth) or alive (survive)
+
+	__m128i both = _mm_setzero_si128();
+	__m128i only_birth = _mm_setzero_si128();
+	__m128i only_survive = _mm_setzero_si128();
+	__m128i equal;
+
+	for (int nn=0; nn<=8; nn++){
+		if (((birth | survive) >> nn) & 1){
+			equal = _mm_cmpeq_epi8(sum, _mm_set1_epi8(nn * current));
+			if (((birth & survive) >> nn) & 1)
+				both = _mm_or_si128(both, equal);
+			else if ((birth >> nn) & 1)
+				only_birth = _mm_or_si128(only_birth, equal);
+			else
+				only_survive = _mm_or_si128(only_survive, equal);
+		}
+	}
+	return _mm_or_si128(both, _mm_or_si128(_mm_andnot_si128(mine_alive, only_birth), _mm_and_si128(mine_alive, only_survive)));
+}
+
+__attribute__((target("avx2")))
+static inline __attribute__((always_inline)) __m256i rule_avx2(__m256i sum, __m256i mine_alive, unsigned char current, unsigned int birth, unsigned int survive){
+
+	// Same as rule_sse2
+
+	__m256i both = _mm256_setzero_si256();
+	__m256i only_birth = _mm256_setzero_si256();
+	__m256i only_survive = _mm256_setzero_si256();
+	__m256i equal;
+
+	for (int nn=0; nn<=8; nn++){
+		if (((birth | survive) >> nn) & 1){
+			equal = _mm256_cmpeq_epi8(sum, _mm256_set1_epi8(nn * current));
+			if (((birth & survive) >> nn) & 1)
+				both = _mm256_or_si256(both, equal);
+			else if ((birth >> nn) & 1)
+				only_birth = _mm256_or_si256(only_birth, equal);
+			else
+				only_survive = _mm256_or_si256(only_survive, equal);
+		}
+	}
+	return _mm256_or_si256(both, _mm256_or_si256(_mm256_andnot_si256(mine_alive, only_birth), _mm256_and_si256(mine_alive, only_survive)));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __attribute__((always_inline)) __mmask64 rule_avx512(__m512i sum, __mmask64 mine_alive, unsigned char current, unsigned int birth, unsigned int survive){
+
+	// Same as rule_sse2, with bit masks
+
+	__mmask64 both = 0;
+	__mmask64 only_birth = 0;
+	__mmask64 only_survive = 0;
+	__mmask64 equal;
+
+	for (int nn=0; nn<=8; nn++){
+		if (((birth | survive) >> nn) & 1){
+			equal = _mm512_cmpeq_epi8_mask(sum, _mm512_set1_epi8(nn * current));
+			if (((birth & survive) >> nn) & 1)
+				both |= equal;
+			else if ((birth >> nn) & 1)
+				only_birth |= equal;
+			else
+				only_survive |= equal;
+		}
+	}
+	return both | (only_birth & ~mine_alive) | (only_survive & mine_alive);
+}
+
+static inline __attribute__((always_inline)) unsigned char rule_compare(unsigned char sum, unsigned char mine, unsigned char current, unsigned int birth, unsigned int survive){
+
+	// Same as rule_sse2 for a single cell (sum = nei*current, mine = current if the cell is alive). It has only
+	// comparisons and no shifts of a variable amount, so the loops that use it are vectorised by the compiler.
+
+	// All the values are chars, otherwise the compiler widens the comparisons to ints.
+
+	unsigned char born = 0;
+	unsigned char survives = 0;
+	unsigned char equal;
+
+	for (int nn=0; nn<=8; nn++){
+		equal = -(unsigned char)(sum == (unsigned char)(nn * current));
+		born |= equal & (unsigned char)-((birth >> nn) & 1);
+		survives |= equal & (unsigned char)-((survive >> nn) & 1);
+	}
+	return ((mine != 0) ? survives : born) & 1;
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+// Evaluation of the rule with a table lookup, for any rule (used by the generic kernels).
+// The table has 0xFF in the byte n if the bit n of the mask is set, and it's indexed by nei with pshufb
+// (that works on 16 bytes, so the table is repeated in each 128 bit lane).
+
+__attribute__((target("avx2")))
+static __m256i rule_table_avx2(unsigned int mask){
+	unsigned char table[16];
+	for (int nn=0; nn<16; nn++){
+		table[nn] = (nn <= 8 && ((mask >> nn) & 1)) ? 0xFF : 0;
+	}
+	return _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)table));
+}
+
+__attribute__((target("avx2")))
+static inline __attribute__((always_inline)) __m256i rule_lookup_avx2(__m256i sum, __m256i mine_alive, unsigned char current, __m256i birth_table, __m256i survive_table){
+	// nei = sum / current (the shift is on 16 bit words, so the bits coming from the other byte are removed)
+	__m256i nei = _mm256_and_si256(_mm256_srli_epi16(sum, current - 1), _mm256_set1_epi8(0x0F));
+	return _mm256_or_si256(_mm256_andnot_si256(mine_alive, _mm256_shuffle_epi8(birth_table, nei)), _mm256_and_si256(mine_alive, _mm256_shuffle_epi8(survive_table, nei)));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static __m512i rule_table_avx512(unsigned int mask){
+	unsigned char table[16];
+	for (int nn=0; nn<16; nn++){
+		table[nn] = (nn <= 8 && ((mask >> nn) & 1)) ? 0xFF : 0;
+	}
+	return _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)table));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __attribute__((always_inline)) __mmask64 rule_lookup_avx512(__m512i sum, __mmask64 mine_alive, unsigned char current, __m512i birth_table, __m512i survive_table){
+	__m512i nei = _mm512_and_si512(_mm512_srli_epi16(sum, current - 1), _mm512_set1_epi8(0x0F));
+	return (_mm512_movepi8_mask(_mm512_shuffle_epi8(birth_table, nei)) & ~mine_alive) | (_mm512_movepi8_mask(_mm512_shuffle_epi8(survive_table, nei)) & mine_alive);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+// Stores of a block of 64 new states for the double-buffered kernels. The non-temporal stores write the whole
+// cache line without reading it first (no write-allocate) and without keeping it in the cache, where it would
+// only push out the rows that are still read. The destination must be aligned to 64 bytes (rows of a halo grid).
+
+__attribute__((target("sse2")))
+static inline __attribute__((always_inline)) void stream_store_sse2(unsigned char *dst, unsigned char *block, int non_temporal){
+	for (int i=0; i<64; i+=16){
+		if (non_temporal)
+			_mm_stream_si128((__m128i *)(dst + i), _mm_loadu_si128((__m128i *)(block + i)));
+		else
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_loadu_si128((__m128i *)(block + i)));
+	}
+}
+
+__attribute__((target("avx2")))
+static inline __attribute__((always_inline)) void stream_store_avx2(unsigned char *dst, unsigned char *block, int non_temporal){
+	for (int i=0; i<64; i+=32){
+		if (non_temporal)
+			_mm256_stream_si256((__m256i *)(dst + i), _mm256_loadu_si256((__m256i *)(block + i)));
+		else
+			_mm256_storeu_si256((__m256i *)(dst + i), _mm256_loadu_si256((__m256i *)(block + i)));
+	}
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline __attribute__((always_inline)) void stream_store_avx512(unsigned char *dst, unsigned char *block, int non_temporal){
+	if (non_temporal)
+		_mm512_stream_si512((void *)dst, _mm512_loadu_si512((void *)block));
+	else
+		_mm512_storeu_si512((void *)dst, _mm512_loadu_si512((void *)block));
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+// Kernels specialised for the common rules (the masks are compile time constants), see GoL_kernels_template.h
+
+#define RULE_SUFFIX conway
+#define RULE_BIRTH RULE_CONWAY_BIRTH
+#define RULE_SURVIVE RULE_CONWAY_SURVIVE
+#include "GoL_kernels_template.h"
+#undef RULE_SUFFIX
+#undef RULE_BIRTH
+#undef RULE_SURVIVE
+
+#define RULE_SUFFIX highlife
+#define RULE_BIRTH RULE_HIGHLIFE_BIRTH
+#define RULE_SURVIVE RULE_HIGHLIFE_SURVIVE
+#include "GoL_kernels_template.h"
+#undef RULE_SUFFIX
+#undef RULE_BIRTH
+#undef RULE_SURVIVE
+
+#define RULE_SUFFIX daynight
+#define RULE_BIRTH RULE_DAYNIGHT_BIRTH
+#define RULE_SURVIVE RULE_DAYNIGHT_SURVIVE
+#include "GoL_kernels_template.h"
+#undef RULE_SUFFIX
+#undef RULE_BIRTH
+#undef RULE_SURVIVE
+
+// Generic kernels, for any other rule (the masks are read at runtime, and the avx2 and avx512 versions use the lookup)
+
+#define RULE_SUFFIX generic
+#define RULE_BIRTH rule_birth
+#define RULE_SURVIVE rule_survive
+#define RULE_LOOKUP
+#include "GoL_kernels_template.h"
+#undef RULE_SUFFIX
+#undef RULE_BIRTH
+#undef RULE_SURVIVE
+#undef RULE_LOOKUP
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+// Table of the lookup version: the index is a 3x6 window of cells (6 bits for each of the three rows, the up row
+// in the lowest bits, and in each row the cell on the left in the lowest bit), the value is the new state of the
+// 4 central cells of the middle row (the first of them in the lowest bit). It's 256 KB, so it stays in L2.
+// It's computed from the masks of the rule, so the same kernel works for every rule.
+static unsigned char static_lut[1 << 18];
+static int static_lut_ready = 0;
+
+// Expansion of the 4 bits of the table into 4 chars (one bit in each)
+static uint32_t static_lut_expand[16];
+
+static void static_lut_init(void){
+
+	// Fills the tables (once, before the evolution, and again if the rule changes)
+
+	int nei, cell, alive;
+
+	if (static_lut_ready)
+		return;
+	for (int index=0; index<(1 << 18); index++){
+		alive = 0;
+		for (int i=0; i<4; i++){
+			// Cell i+1 of the middle row, neighbours in the columns i, i+1, i+2 of the three rows
+			nei = 0;
+			for (int row=0; row<3; row++){
+				for (int col=i; col<i+3; col++){
+					nei += (index >> (6*row + col)) & 1;
+				}
+			}
+			cell = (index >> (6 + i + 1)) & 1;
+			nei -= cell;
+			alive |= rule_scalar(cell, nei, rule_birth, rule_survive) << i;
+		}
+		static_lut[index] = alive;
+	}
+	for (int bits=0; bits<16; bits++){
+		static_lut_expand[bits] = 0;
+		for (int i=0; i<4; i++){
+			static_lut_expand[bits] |= (uint32_t)((bits >> i) & 1) << (8*i);
+		}
+	}
+	static_lut_ready = 1;
+}
+
+static inline uint32_t static_lut_bits(unsigned char *row, int x, unsigned char current){
+	// States of the cells from x to x+3 (the one in x in the lowest bit)
+	uint32_t v;
+	memcpy(&v, row + x, 4);
+	v = (v >> (current - 1)) & 0x01010101;
+	return (v * 0x01020408) >> 24;
+}
+
+static void static_row_lut(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+
+	// Lookup version, without vector instructions. The "current" bits of 4 cells of each row are packed in a
+	// nibble with a multiplication, and the windows of 6 cells (the 4 cells with their left and right neighbours)
+	// of the three rows give the index of the table. The nibbles of the following 4 cells are loaded while
+	// moving along the row, so each cell is read only once.
+
+	uint32_t up_prev, up_cur, up_next;  // nibbles of the cells from x-4 to x+7
+	uint32_t my_prev, my_cur, my_next;
+	uint32_t down_prev, down_cur, down_next;
+	uint32_t index, mine;
+	uint32_t cur = current * 0x01010101;
+	int x;
+
+	static_lut_init();
+
+	x = x_start;
+	if (x == 0 && x_end > 0){
+		static_row_scalar_generic(up_row, my_row, down_row, 0, 1, xsize, current, next);  // first cell (wraps on the left)
+		x = 1;
+	}
+	if (x+8 <= xsize && x+4 <= x_end){
+		// Only the cell on the left (x-1) of the previous nibble is needed
+		up_prev = ((up_row[x-1] & current) != 0) << 3;
+		my_prev = ((my_row[x-1] & current) != 0) << 3;
+		down_prev = ((down_row[x-1] & current) != 0) << 3;
+		up_cur = static_lut_bits(up_row, x, current);
+		my_cur = static_lut_bits(my_row, x, current);
+		down_cur = static_lut_bits(down_row, x, current);
+
+		for (; x+8 <= xsize && x+4 <= x_end; x+=4){
+			up_next = static_lut_bits(up_row, x+4, current);
+			my_next = static_lut_bits(my_row, x+4, current);
+			down_next = static_lut_bits(down_row, x+4, current);
+
+			// Windows of the cells from x-1 to x+4
+			index = (up_prev >> 3) | (up_cur << 1) | ((up_next & 1) << 5);
+			index |= ((my_prev >> 3) | (my_cur << 1) | ((my_next & 1) << 5)) << 6;
+			index |= ((down_prev >> 3) | (down_cur << 1) | ((down_next & 1) << 5)) << 12;
+
+			memcpy(&mine, my_row + x, 4);
+			mine = (mine & cur) | (static_lut_expand[static_lut[index]] * next);
+			memcpy(my_row + x, &mine, 4);
+
+			up_prev = up_cur;
+			my_prev = my_cur;
+			down_prev = down_cur;
+			up_cur = up_next;
+			my_cur = my_next;
+			down_cur = down_next;
+		}
+	}
+	static_row_scalar_generic(up_row, my_row, down_row, x, x_end, xsize, current, next);  // remaining cells (the last one wraps on the right)
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+// Change scan for the ordered evolution: the cells use the encoding of ordered_evolution (nei*4 + prev*2 + state)
+// and the bit i of the mask is set if the cell i would change state with the value it has now.
+// The tables are built from the rule by static_update_kernel: ordered_flip_table is indexed by the whole value,
+// the 16 byte tables by nei with pshufb (0xFF if a dead cell is born / if a live cell dies).
+static unsigned char ordered_flip_table[64];
+static unsigned char ordered_birth_table[16];
+static unsigned char ordered_death_table[16];
+
+static void ordered_tables_init(void){
+	for (int val=0; val<64; val++){
+		ordered_flip_table[val] = ((val >> 2) <= 8) && (RULE_NEW_STATE(val & 1, val >> 2) != (val & 1));
+	}
+	for (int nn=0; nn<16; nn++){
+		ordered_birth_table[nn] = (nn <= 8 && ((rule_birth >> nn) & 1)) ? 0xFF : 0;
+		ordered_death_table[nn] = (nn <= 8 && !((rule_survive >> nn) & 1)) ? 0xFF : 0;
+	}
+}
+
+static uint64_t ordered_scan_scalar(unsigned char *cells, int count){
+	uint64_t mask = 0;
+	for (int i=0; i<count; i++){
+		mask |= (uint64_t)ordered_flip_table[cells[i] & 63] << i;
+	}
+	return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t ordered_scan_avx2(unsigned char *cells, int count){
+	__m256i birth = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)ordered_birth_table));
+	__m256i death = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)ordered_death_table));
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i+32<=count; i+=32){
+		__m256i val = _mm256_loadu_si256((__m256i *)&cells[i]);
+		__m256i nei = _mm256_and_si256(_mm256_srli_epi16(val, 2), _mm256_set1_epi8(0x0F));
+		__m256i alive = _mm256_cmpeq_epi8(_mm256_and_si256(val, _mm256_set1_epi8(1)), _mm256_set1_epi8(1));
+		__m256i flip = _mm256_blendv_epi8(_mm256_shuffle_epi8(birth, nei), _mm256_shuffle_epi8(death, nei), alive);
+		mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(flip) << i;
+	}
+	for (; i<count; i++){
+		mask |= (uint64_t)ordered_flip_table[cells[i] & 63] << i;
+	}
+	return mask;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t ordered_scan_avx512(unsigned char *cells, int count){
+	__m512i birth = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)ordered_birth_table));
+	__m512i death = _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)ordered_death_table));
+	__mmask64 valid = (count >= 64) ? ~(__mmask64)0 : (((__mmask64)1 << count) - 1);
+	__m512i val = _mm512_maskz_loadu_epi8(valid, cells);  // the cells after count are not read
+	__m512i nei = _mm512_and_si512(_mm512_srli_epi16(val, 2), _mm512_set1_epi8(0x0F));
+	__mmask64 alive = _mm512_test_epi8_mask(val, _mm512_set1_epi8(1));
+	return ((_mm512_movepi8_mask(_mm512_shuffle_epi8(birth, nei)) & ~alive) | (_mm512_movepi8_mask(_mm512_shuffle_epi8(death, nei)) & alive)) & valid;
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+static void static_row_first_call(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next);
+static void static_padded_first_call(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next);
+static void static_padded_row_kernel(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next);
+static void static_stream_first_call(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize);
+static uint64_t ordered_scan_first_call(unsigned char *cells, int count);
+
+typedef void (*static_row_function)(unsigned char *, unsigned char *, unsigned char *, int, int, int, unsigned char, unsigned char);
+typedef void (*static_padded_function)(unsigned char *, unsigned char *, unsigned char *, int, unsigned char, unsigned char);
+typedef void (*static_stream_function)(unsigned char *, unsigned char *, unsigned char *, unsigned char *, int);
+typedef uint64_t (*ordered_scan_function)(unsigned char *, int);
+
+// Version of the kernel used by static_evolve_row (and by static_evolve_padded_row, static_stream_row and ordered_flip_mask).
+// If select_static_kernel is never called the best version is chosen at the first call.
+static static_row_function static_row_kernel = static_row_first_call;
+static static_padded_function static_padded_kernel = static_padded_first_call;
+static static_stream_function static_stream_kernel = static_stream_first_call;
+static ordered_scan_function ordered_scan_kernel = ordered_scan_first_call;
+static const char *static_row_kernel_name = "none";
+
+// Versions of the kernels for each rule (the last one is the generic version, for all the other rules)
+#define STATIC_ISA_SCALAR 0
+#define STATIC_ISA_LUT 1
+#define STATIC_ISA_SSE2 2
+#define STATIC_ISA_AVX2 3
+#define STATIC_ISA_AVX512 4
+static const char *static_isa_names[] = {"scalar", "lut", "sse2", "avx2", "avx512"};
+static const struct {
+	unsigned int birth, survive;
+	static_row_function kernels[5];  // in the order of static_isa_names
+	static_padded_function padded[5];  // the scalar and lookup versions have no padded kernel, they use their row kernel
+	static_stream_function stream[5];  // the scalar and lookup versions use the sse2 double-buffered kernel
+} static_rules[] = {
+	{RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE, {static_row_scalar_conway, static_row_lut, static_row_sse2_conway, static_row_avx2_conway, static_row_avx512_conway},
+		{static_padded_row_kernel, static_padded_row_kernel, static_row_padded_sse2_conway, static_row_padded_avx2_conway, static_row_padded_avx512_conway},
+		{static_row_stream_sse2_conway, static_row_stream_sse2_conway, static_row_stream_sse2_conway, static_row_stream_avx2_conway, static_row_stream_avx512_conway}},
+	{RULE_HIGHLIFE_BIRTH, RULE_HIGHLIFE_SURVIVE, {static_row_scalar_highlife, static_row_lut, static_row_sse2_highlife, static_row_avx2_highlife, static_row_avx512_highlife},
+		{static_padded_row_kernel, static_padded_row_kernel, static_row_padded_sse2_highlife, static_row_padded_avx2_highlife, static_row_padded_avx512_highlife},
+		{static_row_stream_sse2_highlife, static_row_stream_sse2_highlife, static_row_stream_sse2_highlife, static_row_stream_avx2_highlife, static_row_stream_avx512_highlife}},
+	{RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVE, {static_row_scalar_daynight, static_row_lut, static_row_sse2_daynight, static_row_avx2_daynight, static_row_avx512_daynight},
+		{static_padded_row_kernel, static_padded_row_kernel, static_row_padded_sse2_daynight, static_row_padded_avx2_daynight, static_row_padded_avx512_daynight},
+		{static_row_stream_sse2_daynight, static_row_stream_sse2_daynight, static_row_stream_sse2_daynight, static_row_stream_avx2_daynight, static_row_stream_avx512_daynight}},
+	{0, 0, {static_row_scalar_generic, static_row_lut, static_row_sse2_generic, static_row_avx2_generic, static_row_avx512_generic},
+		{static_padded_row_kernel, static_padded_row_kernel, static_row_padded_sse2_generic, static_row_padded_avx2_generic, static_row_padded_avx512_generic},
+		{static_row_stream_sse2_generic, static_row_stream_sse2_generic, static_row_stream_sse2_generic, static_row_stream_avx2_generic, static_row_stream_avx512_generic}}
+};
+static int static_isa = -1;  // version chosen by select_static_kernel (-1 if it wasn't called yet)
+
+// Change scan of the ordered evolution for each version (the same for all the rules, it uses the tables)
+static const ordered_scan_function ordered_scans[5] = {ordered_scan_scalar, ordered_scan_scalar, ordered_scan_scalar, ordered_scan_avx2, ordered_scan_avx512};
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+static void static_update_kernel(void){
+
+	// Takes the kernel of the chosen version for the rule in use
+
+	int r = 0;
+	int n_rules = sizeof(static_rules) / sizeof(static_rules[0]);
+	while (r < n_rules-1 && (static_rules[r].birth != rule_birth || static_rules[r].survive != rule_survive))
+		r++;
+	if (static_isa == STATIC_ISA_LUT)
+		static_lut_init();
+	static_row_kernel = static_rules[r].kernels[static_isa];
+	static_padded_kernel = static_rules[r].padded[static_isa];
+	static_stream_kernel = static_rules[r].stream[static_isa];
+	ordered_tables_init();
+	ordered_scan_kernel = ordered_scans[static_isa];
+	static_row_kernel_name = static_isa_names[static_isa];
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+int select_static_kernel(const char *isa){
+
+	// Chooses the version of the row kernel. isa can be "scalar", "lut", "sse2", "avx2", "avx512",
+	// or NULL/"auto" to take the widest version supported by the cpu (checked with CPUID).
+	// Without vector instructions the lookup version is used.
+	// Returns 0 if the requested version is used and 1 if it's not known or not supported by
+	// the cpu (in this case the widest supported version is used).
+
+	int supported[5];
+
+	__builtin_cpu_init();
+	supported[STATIC_ISA_SCALAR] = 1;
+	supported[STATIC_ISA_LUT] = 1;
+	supported[STATIC_ISA_SSE2] = __builtin_cpu_supports("sse2");
+	supported[STATIC_ISA_AVX2] = __builtin_cpu_supports("avx2");
+	supported[STATIC_ISA_AVX512] = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+
+	if (isa != NULL && strcmp(isa, "auto") != 0){
+		for (int i=0; i<5; i++){
+			if (strcmp(isa, static_isa_names[i]) == 0 && supported[i]){
+				static_isa = i;
+				static_update_kernel();
+				return 0;
+			}
+		}
+	}
+
+	// Taking the widest version supported
+	static_isa = STATIC_ISA_AVX512;
+	while (!supported[static_isa])
+		static_isa--;
+	if (static_isa == STATIC_ISA_SCALAR)
+		static_isa = STATIC_ISA_LUT;
+	static_update_kernel();
+	return (isa != NULL && strcmp(isa, "auto") != 0);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+int set_rule(const char *rule){
+
+	// Sets the rule of the evolution from a string like "B3/S23" (the digits are the numbers of neighbours
+	// that make a cell born or survive). Returns 0 if the rule is valid and 1 otherwise (the rule is not changed).
+	// If a kernel was already chosen, it's replaced with the one for the new rule.
+
+	unsigned int birth = 0, survive = 0;
+	const char *c = rule;
+
+	if (rule == NULL || (*c != 'B' && *c != 'b'))
+		return 1;
+	for (c++; *c >= '0' && *c <= '8'; c++)
+		birth |= 1u << (*c - '0');
+	if (*c != '/')
+		return 1;
+	c++;
+	if (*c != 'S' && *c != 's')
+		return 1;
+	for (c++; *c >= '0' && *c <= '8'; c++)
+		survive |= 1u << (*c - '0');
+	if (*c != '\0')
+		return 1;
+
+	rule_birth = birth;
+	rule_survive = survive;
+	static_lut_ready = 0;  // the table depends on the rule
+	if (static_isa >= 0)
+		static_update_kernel();
+	return 0;
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+const char * static_kernel_name(void){
+	// Name of the version of the row kernel in use
+	return static_row_kernel_name;
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+static void static_row_first_call(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+	// Used only if select_static_kernel wasn't called before the evolution
+	select_static_kernel(NULL);
+	static_row_kernel(up_row, my_row, down_row, x_start, x_end, xsize, current, next);
+}
+
+static void static_padded_first_call(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+	select_static_kernel(NULL);
+	static_padded_kernel(up_row, my_row, down_row, xsize, current, next);
+}
+
+static void static_stream_first_call(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize){
+	select_static_kernel(NULL);
+	static_stream_kernel(up_row, my_row, down_row, new_row, xsize);
+}
+
+static uint64_t ordered_scan_first_call(unsigned char *cells, int count){
+	select_static_kernel(NULL);
+	return ordered_scan_kernel(cells, count);
+}
+
+static void static_padded_row_kernel(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+	// Padded kernel of the scalar and lookup versions: their row kernel (it doesn't use the ghost columns)
+	static_row_kernel(up_row, my_row, down_row, 0, xsize, xsize, current, next);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+void static_evolve_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+
+	// Uses the version chosen by select_static_kernel
+	static_row_kernel(up_row, my_row, down_row, 0, xsize, xsize, current, next);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+void static_evolve_segment(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+
+	// Evolves only the cells from x_start to x_end-1 of the row (the neighbours still wrap on the torus)
+	static_row_kernel(up_row, my_row, down_row, x_start, x_end, xsize, current, next);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+void static_evolve_padded_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+
+	// Evolves a row of a halo grid (GoL_parallel_grid.c): the ghost columns (my_row[-1] and my_row[xsize], and the
+	// same for the other rows) must already contain the last and the first cell, and the rows must be writable
+	// up to the next multiple of 64 cells. Only the "next" bit of the ghost columns can be changed.
+	static_padded_kernel(up_row, my_row, down_row, xsize, current, next);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+void static_stream_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize){
+
+	// Writes in new_row the new states of my_row, for the double-buffered evolution: the rows are rows of two halo
+	// grids (GoL_parallel_grid.c) with one state per char (0 or 1), and the ghost columns of the rows that are read
+	// must be filled. The ghost columns of new_row are filled too. Most of new_row is written with non-temporal
+	// stores, so a fence (_mm_sfence) is needed before other threads or MPI read it.
+	static_stream_kernel(up_row, my_row, down_row, new_row, xsize);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+uint64_t ordered_flip_mask(unsigned char *cells, int count){
+
+	// Finds the cells that would change state among count (at most 64) consecutive cells in the encoding of
+	// ordered_evolution (nei*4 + prev*2 + state): the bit i of the result is set if the cell i would change
+	// state with its value. The other cells keep their state, unless their value is changed before they are evolved.
+	return ordered_scan_kernel(cells, count);
+}
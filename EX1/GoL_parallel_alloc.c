@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "mpi.h"
+#include "GoL_parallel_alloc.h"
+#include <omp.h>
+
+// Allocator for the grids of the MPI processes.
+//
+// With malloc the pages of a grid are placed (first touch) on the NUMA node of the thread that writes them first,
+// which is the master thread in read_pgm_image/MPI_Scatterv, so with many threads all of them read the same node.
+// Here each page is written first by the omp thread that owns its band of rows (the bands of schedule( static ),
+// the schedule of the loops on the rows of the evolutions), so it's placed on the node of that thread.
+// This needs the threads to be bound to the cores (OMP_PROC_BIND, OMP_PLACES), otherwise they can move after the
+// first touch. The grid is mapped aligned to 2 MB and backed by huge pages (MAP_HUGETLB if there are reserved
+// huge pages, otherwise transparent huge pages with madvise), so the large boards need much fewer TLB entries.
+// A huge page is placed by the first thread that touches it, so the bands are placed with a granularity of 2 MB.
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+#define GRID_HEADER 64     // the header is before the grid and keeps it aligned to 64 bytes
+#define MAX_NODES 64       // NUMA nodes counted in the report
+
+typedef struct {
+	size_t size;   // size of the mapping (header included)
+	size_t used;   // bytes used by the grid (header included)
+	int hugetlb;   // 1 if mapped with MAP_HUGETLB
+} grid_header;
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+unsigned char * grid_alloc(int rows, size_t row_bytes){
+
+	// Allocates a grid of rows*row_bytes chars set to 0, placing the pages of each band of rows on the NUMA node
+	// of the thread that owns it. Returns NULL if the memory can't be mapped.
+
+	size_t size = ((GRID_HEADER + (size_t)rows * row_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+	unsigned char *base = MAP_FAILED;
+	int hugetlb = 0;
+
+#ifdef MAP_HUGETLB
+	base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	hugetlb = (base != MAP_FAILED);
+#endif
+	if (base == MAP_FAILED){
+		// Mapping 2 MB more and removing the parts before and after the first 2 MB boundary
+		unsigned char *mapped = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapped == MAP_FAILED)
+			return NULL;
+		base = (unsigned char *)(((uintptr_t)mapped + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+		if (base > mapped)
+			munmap(mapped, base - mapped);
+		munmap(base + size, (mapped + HUGE_PAGE_SIZE) - base);
+#ifdef MADV_HUGEPAGE
+		madvise(base, size, MADV_HUGEPAGE);
+#endif
+	}
+
+	((grid_header *)base)->size = size;
+	((grid_header *)base)->used = GRID_HEADER + (size_t)rows * row_bytes;
+	((grid_header *)base)->hugetlb = hugetlb;
+	unsigned char *memory = base + GRID_HEADER;
+
+	// First touch of the rows, with the same schedule( static ) of the loops on the rows of the evolutions:
+	// each thread touches the band of rows it's going to evolve
+	#pragma omp parallel for schedule( static )
+	for (int y=0; y<rows; y++){
+		memset(memory + (size_t)y * row_bytes, 0, row_bytes);
+	}
+	return memory;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void grid_free(unsigned char *memory){
+	if (memory != NULL)
+		munmap(memory - GRID_HEADER, ((grid_header *)(memory - GRID_HEADER))->size);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static size_t anon_huge_bytes(unsigned char *start, size_t size){
+
+	// Bytes of the range backed by transparent huge pages (AnonHugePages of the mappings in /proc/self/smaps)
+
+	FILE *fp = fopen("/proc/self/smaps", "r");
+	char line[256];
+	unsigned long low, high;
+	size_t kb, total = 0;
+	int inside = 0;
+
+	if (fp == NULL)
+		return 0;
+	while (fgets(line, sizeof(line), fp) != NULL){
+		if (sscanf(line, "%lx-%lx ", &low, &high) == 2){
+			inside = (low < (uintptr_t)(start + size)) && (high > (uintptr_t)start);
+		}else if (inside && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1){
+			total += kb * 1024;
+		}
+	}
+	fclose(fp);
+	return total;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void grid_placement_report(unsigned char *memory, const char *label){
+
+	// Reports (process 0, on stderr) how the grids allocated by grid_alloc are placed: the part backed by huge pages
+	// and the fraction of the pages on each NUMA node, summed over all processes. It must be called by all processes.
+	// The node of each page is asked to the kernel with move_pages (without moving it).
+
+	grid_header *header = (grid_header *)(memory - GRID_HEADER);
+	unsigned char *base = (unsigned char *)header;
+	long int page_size = sysconf(_SC_PAGESIZE);
+	long int n_pages = (header->used + page_size - 1) / page_size;
+	size_t huge;
+	long int local_counts[MAX_NODES + 3] = {0};  // pages on each node, pages without a node, huge page bytes, bytes
+	long int counts[MAX_NODES + 3];
+	void *pages[1024];
+	int status[1024];
+	int rank;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	for (long int first=0; first<n_pages; first+=1024){
+		int batch = (n_pages - first < 1024) ? (int)(n_pages - first) : 1024;
+		for (int i=0; i<batch; i++){
+			pages[i] = base + (first + i) * page_size;
+		}
+		if (syscall(SYS_move_pages, 0, (unsigned long)batch, pages, NULL, status, 0) != 0){
+			for (int i=0; i<batch; i++)
+				status[i] = -1;
+		}
+		for (int i=0; i<batch; i++){
+			if (status[i] >= 0 && status[i] < MAX_NODES)
+				local_counts[status[i]]++;
+			else
+				local_counts[MAX_NODES]++;
+		}
+	}
+	huge = header->hugetlb ? header->size : anon_huge_bytes(base, header->size);
+	local_counts[MAX_NODES + 1] = (huge < header->used) ? huge : header->used;
+	local_counts[MAX_NODES + 2] = header->used;
+
+	MPI_Reduce(local_counts, counts, MAX_NODES + 3, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0){
+		long int total_pages = 0;
+		for (int node=0; node<=MAX_NODES; node++)
+			total_pages += counts[node];
+		fprintf(stderr, "%s: %.1f MB, on huge pages: %.1f%%, pages on the NUMA nodes:", label,
+		        counts[MAX_NODES + 2] / 1048576.0, 100.0 * counts[MAX_NODES + 1] / counts[MAX_NODES + 2]);
+		for (int node=0; node<MAX_NODES; node++){
+			if (counts[node] > 0)
+				fprintf(stderr, " %d: %.1f%%", node, 100.0 * counts[node] / total_pages);
+		}
+		if (counts[MAX_NODES] > 0)
+			fprintf(stderr, " unknown: %.1f%%", 100.0 * counts[MAX_NODES] / total_pages);
+		fprintf(stderr, "\n");
+	}
+}
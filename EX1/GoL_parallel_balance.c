@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_alloc.h"
+#include "GoL_parallel_balance.h"
+#include <omp.h>
+
+// Tags of the rows moved between neighbouring processes by the balancing (the ghost rows use 1 and 0)
+#define TAG_BALANCE_UP 3
+#define TAG_BALANCE_DOWN 2
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void move_rows(halo_grid *from, int from_first, halo_grid *to, int to_first, int count){
+	// Copies count whole rows (with their ghost columns) from one halo grid to another (the rows are contiguous)
+	if (count > 0){
+		memcpy(halo_row(to, to_first) - 64, halo_row(from, from_first) - 64, (size_t)count * from->stride);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static int balance_rows(halo_grid *halo, int xsize, double busy, int *num_cells, int *displs){
+
+	// Moves rows between neighbouring processes so that their compute times (busy, since the last balancing step)
+	// become proportional to their rows. All the processes compute the same new partition from the gathered times:
+	//
+	// 	- the speed of a process is its rows over its busy time, and the boundary between the process r and r+1 goes
+	// 	  where the cumulative speed of the processes 0..r reaches its share of the rows of the board;
+	// 	- the rows go only through the links between r and r+1 (not between the last and the first process,
+	// 	  so the rows of the processes stay in order for the gathers), and on each link at most half of the rows of
+	// 	  the process that gives them (so every process keeps at least one row, and the steps are damped).
+	//
+	// The rows are moved with their current encoding (both bits), then num_cells and displs describe the new partition.
+	// Returns the number of rows moved on all the links (the same in all the processes).
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+	double *times = (double *)malloc(size * sizeof(double));
+	int *boundary = (int *)malloc((size + 1) * sizeof(int));      // first row of each process (and the rows of the board)
+	int *new_boundary = (int *)malloc((size + 1) * sizeof(int));
+	MPI_Allgather(&busy, 1, MPI_DOUBLE, times, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+
+	double max_time = 0, total_time = 0, total_speed = 0;
+	int positive = 1;
+	for (int r=0; r<size; r++){
+		boundary[r] = displs[r] / xsize;
+		max_time = (times[r] > max_time) ? times[r] : max_time;
+		total_time += times[r];
+		positive = positive && (times[r] > 0);
+		if (positive){
+			total_speed += (num_cells[r] / xsize) / times[r];
+		}
+	}
+	boundary[size] = boundary[size - 1] + num_cells[size - 1] / xsize;
+
+	// Nothing moves if the processes are already balanced
+	int balanced = !positive || max_time <= (1 + BALANCE_TOLERANCE) * total_time / size;
+
+	new_boundary[0] = boundary[0];
+	new_boundary[size] = boundary[size];
+	double speed = 0;
+	int moved = 0;
+	for (int r=0; r<size-1; r++){
+		int rows = (boundary[r+1] - boundary[r]);
+		int rows_below = (boundary[r+2] - boundary[r+1]);
+		int delta = 0;
+		if (!balanced){
+			speed += rows / times[r];
+			delta = (int)(boundary[size] * speed / total_speed + 0.5) - boundary[r+1];
+		}
+		if (delta > 0 && delta > (rows_below - 1) / 2){
+			delta = (rows_below - 1) / 2;
+		}
+		if (delta < 0 && -delta > (rows - 1) / 2){
+			delta = -((rows - 1) / 2);
+		}
+		new_boundary[r+1] = boundary[r+1] + delta;
+		moved += abs(delta);
+	}
+	// The clamped moves can all be 0 too: then the rows stay where they are
+	if (moved == 0){
+		free(times);
+		free(boundary);
+		free(new_boundary);
+		return 0;
+	}
+
+	int first = boundary[rank], last = boundary[rank + 1];            // rows [first, last) of the process
+	int new_first = new_boundary[rank], new_last = new_boundary[rank + 1];
+	int top_neighbour = rank - 1;
+	int bottom_neighbour = rank + 1;
+
+	halo_grid new_halo;
+	halo_grid_init(&new_halo, xsize, new_last - new_first);
+
+	MPI_Request requests[2];
+	int n_requests = 0;
+
+	// Link with the process above: the rows [first, new_first) go up, or the rows [new_first, first) come down
+	if (rank > 0 && new_first > first){
+		MPI_Isend(halo_row(halo, 0) - 64, (new_first - first) * halo->stride, MPI_UNSIGNED_CHAR, top_neighbour, TAG_BALANCE_UP, MPI_COMM_WORLD, &requests[n_requests++]);
+	}else if (rank > 0 && new_first < first){
+		MPI_Irecv(halo_row(&new_halo, 0) - 64, (first - new_first) * new_halo.stride, MPI_UNSIGNED_CHAR, top_neighbour, TAG_BALANCE_DOWN, MPI_COMM_WORLD, &requests[n_requests++]);
+	}
+	// Link with the process below: the rows [new_last, last) go down, or the rows [last, new_last) come up
+	if (rank < size - 1 && new_last < last){
+		MPI_Isend(halo_row(halo, new_last - first) - 64, (last - new_last) * halo->stride, MPI_UNSIGNED_CHAR, bottom_neighbour, TAG_BALANCE_DOWN, MPI_COMM_WORLD, &requests[n_requests++]);
+	}else if (rank < size - 1 && new_last > last){
+		MPI_Irecv(halo_row(&new_halo, last - new_first) - 64, (new_last - last) * new_halo.stride, MPI_UNSIGNED_CHAR, bottom_neighbour, TAG_BALANCE_UP, MPI_COMM_WORLD, &requests[n_requests++]);
+	}
+
+	// The rows kept by the process
+	int keep_first = (first > new_first) ? first : new_first;
+	int keep_last = (last < new_last) ? last : new_last;
+	move_rows(halo, keep_first - first, &new_halo, keep_first - new_first, keep_last - keep_first);
+
+	MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+	halo_grid_free(halo);
+	*halo = new_halo;
+
+	for (int r=0; r<size; r++){
+		num_cells[r] = (new_boundary[r+1] - new_boundary[r]) * xsize;
+		displs[r] = new_boundary[r] * xsize;
+	}
+
+	free(times);
+	free(boundary);
+	free(new_boundary);
+	return moved;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void balanced_static_evolution(unsigned char **my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int *my_chunk, int n, int s, int period) {
+
+	// Static evolution (in-place, as static_evolution) where the rows of the processes are not fixed: every period
+	// generations each process measures the time spent evolving its rows (the waits for the ghost rows are not counted)
+	// and the boundary rows are moved between neighbouring processes to even out the times (see balance_rows).
+	// The cost of a row is the same everywhere on the board, so the imbalance comes from the processes: cores of
+	// different speed, nodes of different types, or other work on some of the cores.
+	//
+	// Since the number of rows of the process can change, the rows are given back in a new *my_grid, with its
+	// number of rows in *my_chunk, and num_cells and displs describe the final partition of the board.
+
+	// MPI communications stucture:
+	//
+	// As static_evolution, and every period generations:
+	// Wait(sendfirst, recvtop, sendlast, recvbottom)
+	// Allgather(busy times)
+	// isend/irecv(rows moved to/from the neighbours)
+	// isend/irecv(sendfirst, recvtop, sendlast, recvbottom) of the new boundary rows
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	halo_grid halo;
+	halo_grid_init(&halo, xsize, *my_chunk);
+	halo_grid_load(&halo, *my_grid);
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*halo.rows*sizeof(unsigned char));
+	int padded_xsize = xsize + 2;
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Rows used in the communications (they change after the rows are moved)
+	unsigned char *top_ghost_row, *first_row, *last_row, *bottom_ghost_row;
+	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
+
+	// Alternating positions of the current and next states of the system
+	char current = 1;
+	char next = 2;
+
+	double busy = 0;        // time spent on the rows since the last balancing step
+	long int moved = 0;     // rows moved between the processes
+	int steps = 0;          // balancing steps with moved rows
+
+	int start = 1;  // the ghost rows have to be shared (at the beginning and after the rows are moved)
+	for (int gen=0; gen<n; gen++) {
+
+		int rows = halo.rows;
+		if (start){
+			top_ghost_row = halo_row(&halo, -1);
+			first_row = halo_row(&halo, 0);
+			last_row = halo_row(&halo, rows - 1);
+			bottom_ghost_row = halo_row(&halo, rows);
+			MPI_Isend(first_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+			MPI_Isend(last_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+			MPI_Irecv(bottom_ghost_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+			MPI_Irecv(top_ghost_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+			start = 0;
+		}
+
+		// The value of current and next alternate between 1 and 2 (first and second bit)
+		current = gen % 2 + 1;
+		next = 2 - gen % 2;
+
+		MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+		// If the process has a single row, the row below the first one is the bottom ghost row
+		if (rows == 1){
+			MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+			MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		}
+
+		double t0 = MPI_Wtime();
+		static_evolve_padded_row(top_ghost_row, first_row, halo_row(&halo, 1), xsize, current, next);
+		halo_fill_columns(first_row, xsize);
+		busy += MPI_Wtime() - t0;
+
+		MPI_Isend(first_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+		MPI_Irecv(top_ghost_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+		t0 = MPI_Wtime();
+		if (rows > 1){
+			static_evolve_padded_row(halo_row(&halo, rows - 2), last_row, bottom_ghost_row, xsize, current, next);
+			halo_fill_columns(last_row, xsize);
+		}
+		busy += MPI_Wtime() - t0;
+
+		MPI_Isend(last_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+		MPI_Irecv(bottom_ghost_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+
+		// Parallel evolution of the central rows
+		t0 = MPI_Wtime();
+		#pragma omp parallel for schedule( static )
+		for(int y=1; y<rows-1; y++){
+			static_evolve_padded_row(halo_row(&halo, y-1), halo_row(&halo, y), halo_row(&halo, y+1), xsize, current, next);
+			halo_fill_columns(halo_row(&halo, y), xsize);
+		}// end omp parallel
+		busy += MPI_Wtime() - t0;
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			for (int y=0; y<rows; y++){
+				for (int x=0; x<xsize; x++){
+					snap_grid[y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+				}
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+		// Balancing step (not after the last generation), with all the ghost rows of the next generation received
+		if (size > 1 && (gen + 1) % period == 0 && gen < n - 1){
+			MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+			MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+			MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+			MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+			int step_moved = balance_rows(&halo, xsize, busy, num_cells, displs);
+			if (step_moved > 0){
+				// New boundary rows: their ghost rows are shared again
+				free(snap_grid);
+				snap_grid = (unsigned char*)malloc(xsize*halo.rows*sizeof(unsigned char));
+				moved += step_moved;
+				steps++;
+				start = 1;
+			}
+			busy = 0;
+		}
+
+	} // End cycle on gen
+
+	// Deallocating all the handles
+	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+	int min_rows = 0, max_rows = 0;
+	MPI_Reduce(&halo.rows, &min_rows, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&halo.rows, &max_rows, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+	if (rank == 0){
+		fprintf(stderr, "Row balancing every %d generations: %ld rows moved in %d steps, rows per process from %d to %d\n",
+		        period, moved, steps, min_rows, max_rows);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file
+	if(s == n){
+		for (int y=0; y<halo.rows; y++){
+			for (int x=0; x<xsize; x++){
+				snap_grid[y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+			}
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+	free(snap_grid);
+
+	// The process keeps its rows in my_grid, reallocated if their number has changed
+	if (halo.rows != *my_chunk){
+		grid_free(*my_grid);
+		*my_grid = grid_alloc(halo.rows, xsize * sizeof(unsigned char));
+		if (*my_grid == NULL){
+			fprintf(stderr, "Can't allocate the %d rows of the process after the row balancing\n", halo.rows);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		*my_chunk = halo.rows;
+	}
+	halo_grid_store(&halo, *my_grid);
+	halo_grid_free(&halo);
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_cart.h"
+#include <immintrin.h>  // _mm_sfence
+#include <omp.h>
+
+// Tags of the halo exchange: the rows as in the other static modes, and the columns
+#define TAG_ROW_DOWN 0     // last row, sent to the bottom neighbour
+#define TAG_ROW_UP 1       // first row, sent to the top neighbour
+#define TAG_COLUMN_LEFT 2  // first column, sent to the left neighbour
+#define TAG_COLUMN_RIGHT 3 // last column, sent to the right neighbour
+#define TAG_BLOCK 4        // blocks scattered and gathered by the process 0
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void cart_split(int length, int parts, int part, int *start, int *count){
+	// Same subdivision of the rows used in main: the first length%parts parts have one more element
+	*count = length / parts + (part < length % parts);
+	*start = part * (length / parts) + ((part < length % parts) ? part : length % parts);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void cart_blocks(unsigned char *grid, halo_grid *g, MPI_Datatype block_type, MPI_Comm cart, int *dims, int xsize, int gather){
+
+	// Scatters the board of the process 0 to the blocks of all the processes (gather = 0), or gathers the blocks
+	// in the board of the process 0 (gather = 1). In the board each block is described by a subarray datatype.
+
+	int rank, size;
+	int coords[2], sizes[2] = {xsize, xsize}, subsizes[2], starts[2];
+	MPI_Datatype subarray;
+	MPI_Comm_rank(cart, &rank);
+	MPI_Comm_size(cart, &size);
+
+	MPI_Request *requests = (MPI_Request *)malloc((size + 1) * sizeof(MPI_Request));
+	int n_requests = 0;
+
+	if (gather)
+		MPI_Isend(halo_row(g, 0), 1, block_type, 0, TAG_BLOCK, cart, &requests[n_requests++]);
+	else
+		MPI_Irecv(halo_row(g, 0), 1, block_type, 0, TAG_BLOCK, cart, &requests[n_requests++]);
+
+	if (rank == 0){
+		for (int r=0; r<size; r++){
+			MPI_Cart_coords(cart, r, 2, coords);
+			cart_split(xsize, dims[0], coords[0], &starts[0], &subsizes[0]);
+			cart_split(xsize, dims[1], coords[1], &starts[1], &subsizes[1]);
+			MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_UNSIGNED_CHAR, &subarray);
+			MPI_Type_commit(&subarray);
+			if (gather)
+				MPI_Irecv(grid, 1, subarray, r, TAG_BLOCK, cart, &requests[n_requests++]);
+			else
+				MPI_Isend(grid, 1, subarray, r, TAG_BLOCK, cart, &requests[n_requests++]);
+			MPI_Type_free(&subarray);  // freed when the communication is complete
+		}
+	}
+	MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+	free(requests);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void cart_static_evolution(unsigned char *grid, int xsize, int n, int s) {
+
+	// Static evolution with a 2D decomposition of the board. With the decomposition in rows each process exchanges
+	// two rows of xsize cells, whatever the number of processes, and the rows of a process become fewer than the
+	// ghost rows. Here the processes are arranged in a periodic 2D grid (MPI_Dims_create, MPI_Cart_create) and each
+	// one has a block of about xsize/sqrt(P) x xsize/sqrt(P) cells, so the halo of a process shrinks as 1/sqrt(P).
+	// The board is taken from grid in the process 0, which scatters the blocks (and gathers them for the snapshots).
+	//
+	// Each block is a halo grid (GoL_parallel_grid.c) as wide as the block, with one state per char (0 or 1) and two
+	// grids swapped at each generation, as in streaming_static_evolution (the rows are evolved by static_stream_row).
+	// The ghost columns come from the left and right neighbours instead of the other end of the row, so the halo is
+	// exchanged in two phases, and the corners travel with the rows:
+	//
+	// MPI communications stucture (for each generation):
+	//
+	// Phase 1: isend/irecv(first and last column) with the left and right neighbours (strided datatype)
+	// Waitall
+	// Phase 2: isend/irecv(first and last row, ghost columns included) with the top and bottom neighbours
+	// Waitall
+	// 	All rows
+	// Writing snapshots (from the source grid)
+	// Swapping the grids
+
+	int world_rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+	// Creating the 2D grid of processes (periodic in both directions, the board is a torus)
+	int dims[2] = {0, 0}, periods[2] = {1, 1}, coords[2];
+	MPI_Comm cart;
+	MPI_Dims_create(size, 2, dims);
+	if (dims[0] > xsize || dims[1] > xsize){
+		if (world_rank == 0)
+			fprintf(stderr, "The board is too small for a %d x %d grid of processes\n", dims[0], dims[1]);
+		return;
+	}
+	MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &cart);
+
+	int rank;
+	MPI_Comm_rank(cart, &rank);
+	MPI_Cart_coords(cart, rank, 2, coords);
+	int top_neighbour, bottom_neighbour, left_neighbour, right_neighbour;
+	MPI_Cart_shift(cart, 0, 1, &top_neighbour, &bottom_neighbour);
+	MPI_Cart_shift(cart, 1, 1, &left_neighbour, &right_neighbour);
+
+	// Block of the process: rows from y0 (ny rows), columns from x0 (nx columns)
+	int y0, ny, x0, nx;
+	cart_split(xsize, dims[0], coords[0], &y0, &ny);
+	cart_split(xsize, dims[1], coords[1], &x0, &nx);
+	if (rank == 0){
+		fprintf(stderr, "Cartesian grid of processes: %d x %d, blocks of %d x %d cells\n", dims[0], dims[1], ny, nx);
+	}
+
+	halo_grid grids[2];
+	halo_grid *source = &grids[0];
+	halo_grid *destination = &grids[1];
+	halo_grid *swap;
+	halo_grid_init(&grids[0], nx, ny);
+	halo_grid_init(&grids[1], nx, ny);
+	int padded_nx = nx + 2;
+
+	// The cells of the block in a halo grid, and a column of the block (the same for both grids, they have the same stride)
+	MPI_Datatype block_type, column_type;
+	MPI_Type_vector(ny, nx, source->stride, MPI_UNSIGNED_CHAR, &block_type);
+	MPI_Type_commit(&block_type);
+	MPI_Type_vector(ny, 1, source->stride, MPI_UNSIGNED_CHAR, &column_type);
+	MPI_Type_commit(&column_type);
+
+	MPI_Request requests[4];
+
+	// Getting the blocks from the process 0
+	cart_blocks(grid, source, block_type, cart, dims, xsize, 0);
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// Phase 1: the ghost columns of the rows of the block
+		MPI_Irecv(halo_row(source, 0) - 1, 1, column_type, left_neighbour, TAG_COLUMN_RIGHT, cart, &requests[0]);
+		MPI_Irecv(halo_row(source, 0) + nx, 1, column_type, right_neighbour, TAG_COLUMN_LEFT, cart, &requests[1]);
+		MPI_Isend(halo_row(source, 0), 1, column_type, left_neighbour, TAG_COLUMN_LEFT, cart, &requests[2]);
+		MPI_Isend(halo_row(source, 0) + nx - 1, 1, column_type, right_neighbour, TAG_COLUMN_RIGHT, cart, &requests[3]);
+		MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+
+		// Phase 2: the ghost rows, with the ghost columns just received (the corners of the halo)
+		MPI_Irecv(halo_row(source, -1) - 1, padded_nx, MPI_UNSIGNED_CHAR, top_neighbour, TAG_ROW_DOWN, cart, &requests[0]);
+		MPI_Irecv(halo_row(source, ny) - 1, padded_nx, MPI_UNSIGNED_CHAR, bottom_neighbour, TAG_ROW_UP, cart, &requests[1]);
+		MPI_Isend(halo_row(source, 0) - 1, padded_nx, MPI_UNSIGNED_CHAR, top_neighbour, TAG_ROW_UP, cart, &requests[2]);
+		MPI_Isend(halo_row(source, ny - 1) - 1, padded_nx, MPI_UNSIGNED_CHAR, bottom_neighbour, TAG_ROW_DOWN, cart, &requests[3]);
+		MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+
+		// Parallel evolution of the rows of the block (the ghost columns written by static_stream_row are
+		// replaced by the exchange of the next generation). Each thread completes its non-temporal stores.
+		#pragma omp parallel
+		{
+			#pragma omp for schedule( static ) nowait
+			for(int y=0; y<ny; y++){
+				static_stream_row(halo_row(source, y-1), halo_row(source, y), halo_row(source, y+1), halo_row(destination, y), nx);
+			}
+			_mm_sfence();
+		}// end omp parallel
+
+		// Writing the snapshot file (the state of this generation is in the source grid)
+		if((gen % s == 0) && (s != n)){
+			cart_blocks(grid, source, block_type, cart, dims, xsize, 1);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(cart);
+		}
+
+		swap = source;
+		source = destination;
+		destination = swap;
+
+	} // End cycle on gen
+
+	// Waiting for all processes before ending
+	MPI_Barrier(cart);
+
+	// Writing the snapshot file (like in static_evolution, the state of the last generation, now in the destination grid)
+	if(s == n){
+		cart_blocks(grid, destination, block_type, cart, dims, xsize, 1);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(cart);
+	}
+
+	MPI_Type_free(&block_type);
+	MPI_Type_free(&column_type);
+	MPI_Comm_free(&cart);
+	halo_grid_free(&grids[0]);
+	halo_grid_free(&grids[1]);
+
+	return;
+}
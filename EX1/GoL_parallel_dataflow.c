@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_dataflow.h"
+#include <omp.h>
+
+// Size of a band of rows (a task evolves a band by one generation)
+#define DATAFLOW_BAND_BYTES (128 * 1024)
+// Bands for each omp thread, at least (smaller bands if the rows of the process are not enough)
+#define DATAFLOW_BANDS_PER_THREAD 4
+// Generations of tasks created before waiting for all of them (and at most until the next snapshot)
+#define DATAFLOW_WINDOW 16
+
+static void evolve_band(halo_grid *g, int y_start, int y_end, int gen){
+
+	// Evolves the rows from y_start to y_end-1 from the generation gen to gen+1
+
+	char current = gen % 2 + 1;
+	char next = 2 - gen % 2;
+	for (int y=y_start; y<y_end; y++){
+		static_evolve_padded_row(halo_row(g, y-1), halo_row(g, y), halo_row(g, y+1), g->xsize, current, next);
+		halo_fill_columns(halo_row(g, y), g->xsize);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void exchange_ghost_rows(halo_grid *g, int top_neighbour, int bottom_neighbour){
+
+	// Sends the first and the last row to the neighbours and receives the ghost rows (with their ghost columns)
+
+	MPI_Request requests[4]; // Handles for the non blocking comm.
+	int rows = g->rows;
+
+	// Each process sends its top row to its top neighbour. The tag is 1
+	MPI_Isend(halo_row(g, 0) - 1, g->xsize + 2, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &requests[0]);
+	// Each process sends its bottom row to its bottom neighbour. The tag is 0
+	MPI_Isend(halo_row(g, rows - 1) - 1, g->xsize + 2, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &requests[1]);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Irecv(halo_row(g, rows) - 1, g->xsize + 2, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &requests[2]);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Irecv(halo_row(g, -1) - 1, g->xsize + 2, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &requests[3]);
+	MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void dataflow_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution without barriers between the generations.
+	// The rows of the process are split in bands and the evolution of a band by one generation is an omp task,
+	// which depends only on the tasks of the same band and of the two adjacent bands at the previous generation.
+	// The dependencies are declared with depend on a token for each band (the task of the band b at the
+	// generation g is inout on the token b and in on the tokens b-1 and b+1), so the runtime orders:
+	// - the task (b, g+1) after (b-1, g), (b, g), (b+1, g), which wrote the rows it reads;
+	// - the task (b, g+2) after (b-1, g+1) and (b+1, g+1), which read its rows with the bit of the generation g+1
+	//   (the one overwritten at g+2).
+	// So adjacent bands are at most one generation apart, which is what the encoding of static_evolution
+	// allows (a row at g+1 still has the state of g in the other bit), and a thread that is done with a band can
+	// move to any band whose neighbours are ready, also of a later generation, instead of waiting at a barrier.
+	// The exchange of the ghost rows of each generation is a task too, with a token for the ghost rows:
+	// it's in on the first and last band (it sends their rows) and inout on the ghost rows, and the first and
+	// last band are in on the ghost rows. So the receive of the ghost rows is a dependency of the first and
+	// last band, and the central bands don't wait for it.
+	// The tasks are created by a single thread, DATAFLOW_WINDOW generations at a time (or until the next snapshot),
+	// and all of them are completed before a snapshot.
+	//
+	// The exchange tasks run on any thread, one at a time (the token of the ghost rows orders them), so
+	// they need MPI_THREAD_SERIALIZED. With a lower level of thread support, the rows are exchanged by the
+	// master thread before the tasks of each generation, with windows of a single generation.
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	int level;
+	MPI_Query_thread(&level);
+	int serialized = (level >= MPI_THREAD_SERIALIZED);
+	int window = serialized ? DATAFLOW_WINDOW : 1;
+	if (!serialized && rank == 0)
+		fprintf(stderr, "MPI_THREAD_SERIALIZED not available, the ghost rows are exchanged between the generations\n");
+
+	halo_grid halo;
+	halo_grid_init(&halo, xsize, my_chunk);
+	halo_grid_load(&halo, my_grid);
+	unsigned char *snap_grid = (unsigned char*)malloc((long int)xsize*my_chunk*sizeof(unsigned char));
+
+	// Height of the bands
+	int band = DATAFLOW_BAND_BYTES / halo.stride;
+	int max_band = my_chunk / (DATAFLOW_BANDS_PER_THREAD * omp_get_max_threads());
+	if (band > max_band)
+		band = max_band;
+	if (band < 1)
+		band = 1;
+	int n_bands = (my_chunk + band - 1) / band;
+
+	// Tokens of the dependencies (only their addresses are used)
+	char *tokens = (char*)malloc(n_bands * sizeof(char));
+	char ghost_token;
+
+	char current;
+	int steps;   // generations of the window
+
+	// Starting the iteration on the windows of generations
+	for (int gen=0; gen<n; gen+=steps) {
+
+		// Writing the snapshot file (the state of the generation gen, in the bit "current")
+		current = gen % 2 + 1;
+		if((gen % s == 0) && (s != n)){
+			//writing the temporary grid
+			for (int y=0; y<my_chunk; y++){
+				for (int x=0; x<xsize; x++){
+					//snap_grid will have the value of the grid at the current state
+					snap_grid[(long int)y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+				}
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+		steps = (n - gen < window) ? (n - gen) : window;
+		if ((s != n) && (s - gen % s < steps))
+			steps = s - gen % s;
+
+		if (!serialized)
+			exchange_ghost_rows(&halo, top_neighbour, bottom_neighbour);
+
+		#pragma omp parallel
+		{
+			#pragma omp single
+			{
+				for (int g=gen; g<gen+steps; g++){
+
+					// Exchange of the ghost rows for the generation g
+					if (serialized){
+						#pragma omp task depend(in: tokens[0], tokens[n_bands - 1]) depend(inout: ghost_token)
+						exchange_ghost_rows(&halo, top_neighbour, bottom_neighbour);
+					}
+
+					for (int b=0; b<n_bands; b++){
+						// Tokens of the rows above and below the band (the ghost rows for the first and the last band)
+						char *above = (b == 0) ? &ghost_token : &tokens[b - 1];
+						char *below = (b == n_bands - 1) ? &ghost_token : &tokens[b + 1];
+						int y_start = b * band;
+						int y_end = (b == n_bands - 1) ? my_chunk : y_start + band;
+
+						#pragma omp task depend(in: *above, *below) depend(inout: tokens[b])
+						evolve_band(&halo, y_start, y_end, g);
+					}
+				}
+			}// the tasks are completed at the implicit barrier
+		}// end omp parallel
+
+	} // End cycle on gen
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file (like in static_evolution, the state of the generation n-1, still in the other bit)
+	if(s == n){
+		current = (n - 1) % 2 + 1;
+		//writing the temporary grid
+		for (int y=0; y<my_chunk; y++){
+			for (int x=0; x<xsize; x++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[(long int)y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+			}
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+	if (snap_grid != NULL)
+		free(snap_grid);
+	free(tokens);
+
+	// The process keeps its rows in my_grid
+	halo_grid_store(&halo, my_grid);
+	halo_grid_free(&halo);
+
+	return;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include <omp.h>
+
+static void evolve_rows(unsigned char *grid_rows, int y_start, int y_end, int xsize, char current, char next){
+
+	// Evolves the rows from y_start to y_end-1 (the positions are relative to grid_rows, so they can be negative
+	// to reach the ghost rows). The work on rows is shared between omp threads like in static_evolution.
+
+	#pragma omp parallel for schedule( static )
+	for(int y=y_start; y<y_end; y++){
+		static_evolve_row(&grid_rows[(long int)(y-1)*xsize], &grid_rows[(long int)y*xsize], &grid_rows[(long int)(y+1)*xsize], xsize, current, next);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void deep_halo_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int halo_depth) {
+
+	// Static evolution with a deep halo (temporal blocking).
+	// Each process keeps halo_depth (H) ghost rows on the top and H on the bottom, contiguous to its rows,
+	// and the ghost rows are exchanged only once every H generations. In the H generations between two exchanges
+	// also the ghost rows are evolved (redundantly, they are evolved also by the neighbour): at each generation
+	// the region with a valid state shrinks by one row on each side, and after H generations only the rows
+	// of the process are valid. This reduces the number of messages by a factor H, at the cost of some extra rows.
+	// The encoding is the same of static_evolution (the state alternates between bit 1 and bit 2).
+	//
+	// In the last generation before an exchange, the H top rows and the H bottom rows are evolved first,
+	// so that they can be sent while the central rows are evolved:
+	//
+	// Wait(sendfirst, recvtop, sendlast, recvbottom)
+	// 	H-1 generations on the rows and on the shrinking ghost region
+	// 	Last generation:
+	// 		First H rows
+	// 		isend/irecv(sendfirst, recvtop)
+	// 		Last H rows
+	// 		isend/irecv(sendlast, recvbottom)
+	// 		Central rows
+	// Writing snapshots (at any generation)
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// The H rows sent by a process must be its own rows, and the first and last H rows should not overlap
+	// (otherwise the ghost rows would be received while they are still used), so H <= (smallest chunk)/2
+	int H = halo_depth;
+	if (H > (xsize / size) / 2)
+		H = (xsize / size) / 2;
+	if (H < 1)
+		H = 1;
+	if (H != halo_depth && rank == 0)
+		fprintf(stderr, "Halo depth reduced from %d to %d (the rows of a process must be at least twice the halo)\n", halo_depth, H);
+
+	// Rows from -H to my_chunk+H-1. my_rows points to the row 0 (the first row of the process)
+	unsigned char *padded_grid = (unsigned char *)malloc((long int)(my_chunk + 2*H) * xsize * sizeof(unsigned char));
+	unsigned char *my_rows = padded_grid + (long int)H * xsize;
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+	memcpy(my_rows, my_grid, (long int)my_chunk * xsize * sizeof(unsigned char));
+
+	// Alternating positions of the current and next states of the system
+	char current = 1;
+	char next = 2;
+	int steps;  // Number of generations between two exchanges (H, or less at the end of the evolution)
+
+	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
+
+	// Sharing the ghost rows to start the generations
+
+	// Each process sends its H top rows to its top neighbour
+	MPI_Isend(&my_rows[0], H*xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+	// Each process sends its H bottom rows to its bottom neighbour
+	MPI_Isend(&my_rows[(long int)(my_chunk - H) * xsize], H*xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+	// Each process receives its H bottom ghost rows from its bottom neighbour
+	MPI_Irecv(&my_rows[(long int)my_chunk * xsize], H*xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+	// Each process receives its H top ghost rows from its top neighbour
+	MPI_Irecv(&my_rows[-(long int)H * xsize], H*xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+	// Starting the iteration on the blocks of generations
+	for (int gen=0; gen<n; gen+=steps) {
+
+		steps = (n - gen < H) ? (n - gen) : H;
+
+		// Waiting for the ghost rows, and for the sends before modifying the rows
+		MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+		for (int j=0; j<steps; j++){
+
+			// Alternating positions of the current and next states of the system
+			current = (gen + j) % 2 + 1;
+			next = 2 - (gen + j) % 2;
+
+			if (j < steps-1){
+				// Evolving the valid region minus one row on each side (it includes part of the ghost rows)
+				evolve_rows(my_rows, -(steps-1) + j, my_chunk + (steps-1) - j, xsize, current, next);
+			}else{
+				// Last generation of the block: only the rows of the process
+
+				// First H rows
+				evolve_rows(my_rows, 0, H, xsize, current, next);
+				// Sending the fist rows. The tag is 1
+				MPI_Isend(&my_rows[0], H*xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+				// Receving the new top ghost rows. The tag is 0
+				MPI_Irecv(&my_rows[-(long int)H * xsize], H*xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+				// Last H rows
+				evolve_rows(my_rows, my_chunk - H, my_chunk, xsize, current, next);
+				// Sending the last rows. The tag is 0
+				MPI_Isend(&my_rows[(long int)(my_chunk - H) * xsize], H*xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+				// Receving the new bottom ghost rows. The tag is 1
+				MPI_Irecv(&my_rows[(long int)my_chunk * xsize], H*xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+
+				// Central rows
+				evolve_rows(my_rows, H, my_chunk - H, xsize, current, next);
+			}
+
+			// Writing the snapshot file
+			if(((gen + j) % s == 0) && (s != n)){
+				//writing the temporary grid
+				for (int i=0; i<xsize*my_chunk; i++){
+					//snap_grid will have the value of the grid at the current state
+					snap_grid[i] = ((my_rows[i] & current) == current);
+				}
+				MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+				if (rank == 0){
+					write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen + j);
+				}
+				MPI_Barrier(MPI_COMM_WORLD);
+			}
+		}
+
+	} // End cycle on gen
+
+	// Deallocating all the handles
+	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file (like in static_evolution)
+	if(s == n){
+		//writing the temporary grid
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = ((my_rows[i] & current) == current);
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	if (padded_grid != NULL)
+		free(padded_grid);
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	return;
+}
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_parallel_init_evol.h"
+#include "GoL_parallel_alloc.h"
+#include "GoL_parallel_ensemble.h"
+#include <omp.h>
+
+// State of a board of the ensemble in a MPI process
+typedef struct {
+	unsigned char *cells;             // rows of the process (ordered encoding)
+	unsigned char *top_ghost_row;
+	unsigned char *bottom_ghost_row;
+	MPI_Request sendfirst;            // handles of the last rows sent
+	MPI_Request sendlast;
+	MPI_Request recvbottom;
+} ensemble_board;
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void ensemble_step(ensemble_board *board, int tag, int xsize, int my_chunk, int top_neighbour, int bottom_neighbour, int *l_ind_pos, int *l_ind_dist){
+
+	// One generation of a board, as in ordered_evolution. The rows sent down have tag "tag", the rows sent up tag+1
+
+	unsigned char *my_grid = board->cells;
+	int stride = 640;  // The minimum size of the fragment of the row in which a thread will work
+	int count;
+
+	// The beginning of the generation is marked by the blocking receive of the upper ghost row
+	MPI_Recv(board->top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	MPI_Wait(&board->sendfirst, MPI_STATUS_IGNORE);
+	MPI_Irecv(board->bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, tag + 1, MPI_COMM_WORLD, &board->recvbottom);
+
+	// Updating the first line (no parallelization) and sending it
+	ordered_first_row(my_grid, board->top_ghost_row, xsize);
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, tag + 1, MPI_COMM_WORLD, &board->sendfirst);
+
+	// Updating the central lines ( PARALLELIZATION )
+	count = l_ind(my_grid, 0, xsize, stride, l_ind_pos, l_ind_dist);
+	for (int y = 1; y < my_chunk-1; y++){
+		#pragma omp parallel for schedule( static, 1 )
+		for (int i = 0; i<count; i++){
+			ordered_fragment(my_grid, y, xsize, l_ind_pos[i], l_ind_dist[i], i == 0);
+		}
+		ordered_fix_fragments(my_grid, y, xsize, count, l_ind_pos, l_ind_dist);
+		count = l_ind(my_grid, y, xsize, stride, l_ind_pos, l_ind_dist);
+	}
+
+	// Updating the last line (no parallelization) and sending it
+	MPI_Wait(&board->recvbottom, MPI_STATUS_IGNORE);
+	MPI_Wait(&board->sendlast, MPI_STATUS_IGNORE);
+	ordered_last_row(my_grid, board->bottom_ghost_row, xsize, my_chunk);
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, tag, MPI_COMM_WORLD, &board->sendlast);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void ensemble_perturb(unsigned char *cells, int b, int xsize, int my_chunk, int first_row){
+
+	// Flips each cell of the rows of the board b (a copy of the input board) with probability ENSEMBLE_PERTURBATION.
+	// Each row has its own generator, seeded with the board and the row in the whole board: the boards are the same
+	// for any number of processes.
+
+	struct drand48_data rand_gen;
+	double random_number;
+
+	for (int y=0; y<my_chunk; y++){
+		srand48_r((long int)b * xsize + first_row + y, &rand_gen);
+		for (int x=0; x<xsize; x++){
+			drand48_r(&rand_gen, &random_number);
+			if (random_number < ENSEMBLE_PERTURBATION){
+				cells[y*xsize + x] = (cells[y*xsize + x] & 1) ^ 1;
+			}
+		}
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void ensemble_snapshot(ensemble_board *board, int b, unsigned char *snap_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int label){
+
+	// Gathers the current state of the board b in the last process, which writes it
+
+	int rank, size;
+	char basename[64];
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+	for (int i=0; i<xsize*my_chunk; i++){
+		snap_grid[i] = board->cells[i] & 1;
+	}
+	MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+	if (rank == size-1){
+		snprintf(basename, sizeof(basename), "./Snapshots/parallel_ordered/board%d_snapshot", b);
+		write_snapshot(grid, 1, xsize, xsize, basename, label);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void ensemble_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int n_boards) {
+
+	// Ordered evolution of an ensemble of n_boards independent boards.
+	// In ordered_evolution each process waits for the last row of the process above before starting a generation,
+	// so the generation goes around the ring one process at a time and only one process works at any moment.
+	// Here each process evolves all the boards, one after the other, and the boards are staggered around the ring:
+	// while the process r evolves the board b, the process r+1 evolves the board b-1 and so on. With at least as many
+	// boards as processes all the processes work at the same time, and the throughput (generations of a board per
+	// second) grows with the number of processes.
+	// The first board is the input board (my_grid), the others are copies of it with a fraction ENSEMBLE_PERTURBATION of
+	// the cells flipped at random, different for each board, so each board has its own evolution (with about the
+	// density of live cells of the input). The board b uses the tags 2b (rows sent down)
+	// and 2b+1 (rows sent up), and has its own handles, so the messages of the different boards are independent.
+	// The snapshots of the board b are ./Snapshots/parallel_ordered/board<b>_snapshot_<gen>.pgm. A snapshot is a
+	// collective of all the processes, so the snapshots stop the pipeline (use -s 0 to measure the throughput).
+	//
+	// MPI communications structure (for each generation):
+	//
+	// for each board b
+	// 	Recv(top_ghost_row of b) (blocking, tag 2b)
+	// 	IRecv(bottom_ghost_row of b) (tag 2b+1)
+	// 		First row
+	// 	ISend(first row of b) (tag 2b+1)
+	// 		Central rows
+	// 	Wait(recvbottom of b)
+	// 		Last row
+	// 	Isend(last row of b) (tag 2b)
+	// for each board b (if it's a snapshot generation)
+	// 	Gatherv(b)
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	ensemble_board *boards = (ensemble_board *)malloc(n_boards * sizeof(ensemble_board));
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+	int* l_ind_pos = (int *)malloc(((xsize/640)+1) * sizeof(int));  // positions of line_independent cells
+	int* l_ind_dist = (int *)malloc(((xsize/640)+1) * sizeof(int)); // lengths of the fragments
+	MPI_Request initial[2];
+	double start_time, elapsed, max_elapsed;
+
+	// Initializing the boards
+	for (int b=0; b<n_boards; b++){
+		ensemble_board *board = &boards[b];
+		if (b == 0){
+			board->cells = my_grid;
+		}else{
+			// The rows of the process are placed on the NUMA nodes of the omp threads that work on them
+			board->cells = grid_alloc(my_chunk, xsize * sizeof(unsigned char));
+			if (board->cells == NULL){
+				fprintf(stderr, "Can't allocate the board %d of the ensemble (%d rows)\n", b, my_chunk);
+				MPI_Abort(MPI_COMM_WORLD, 1);
+			}
+			memcpy(board->cells, my_grid, (size_t)xsize * my_chunk);
+			ensemble_perturb(board->cells, b, xsize, my_chunk, displs[rank] / xsize);
+		}
+		board->top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+		board->bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+		board->sendfirst = MPI_REQUEST_NULL;
+		board->sendlast = MPI_REQUEST_NULL;
+	}
+
+	// Getting the ghost rows and encoding the boards (as in ordered_evolution)
+	for (int b=0; b<n_boards; b++){
+		ensemble_board *board = &boards[b];
+		MPI_Isend(&board->cells[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 2*b + 1, MPI_COMM_WORLD, &initial[0]);
+		MPI_Isend(&board->cells[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 2*b, MPI_COMM_WORLD, &initial[1]);
+		MPI_Recv(board->bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 2*b + 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		MPI_Recv(board->top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 2*b, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		MPI_Waitall(2, initial, MPI_STATUSES_IGNORE);
+		ordered_encode(board->cells, xsize, my_chunk, board->top_ghost_row, board->bottom_ghost_row);
+
+		// Sending the rows that begin the gen cycle. They are non-blocking, so they are fine also with one process
+		if (rank == size-1){
+			MPI_Isend(&board->cells[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 2*b, MPI_COMM_WORLD, &board->sendlast);
+		}
+		if (rank != 0){
+			MPI_Isend(&board->cells[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 2*b + 1, MPI_COMM_WORLD, &board->sendfirst);
+		}
+	}
+
+	start_time = MPI_Wtime();
+
+	// Starting the iteration on the generations
+
+	for (int gen=0; gen<n; gen++) {
+
+		for (int b=0; b<n_boards; b++){
+			ensemble_step(&boards[b], 2*b, xsize, my_chunk, top_neighbour, bottom_neighbour, l_ind_pos, l_ind_dist);
+		}
+
+		// Writing the snapshot files
+		if((gen % s == 0) && (s != n)){
+			for (int b=0; b<n_boards; b++){
+				ensemble_snapshot(&boards[b], b, snap_grid, grid, num_cells, displs, xsize, my_chunk, gen);
+			}
+		}
+
+	} // End cycle on gen
+
+	// Deallocating the handles and receiving the last messages to end the communication
+	for (int b=0; b<n_boards; b++){
+		MPI_Wait(&boards[b].sendfirst, MPI_STATUS_IGNORE);
+		MPI_Wait(&boards[b].sendlast, MPI_STATUS_IGNORE);
+		if (rank == 0){
+			MPI_Recv(boards[b].top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 2*b, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		}
+		if (rank != size-1){
+			MPI_Recv(boards[b].bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 2*b + 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		}
+	}
+
+	// Reporting the throughput of the ensemble (process 0, on stderr)
+	elapsed = MPI_Wtime() - start_time;
+	MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if (rank == 0 && max_elapsed > 0){
+		fprintf(stderr, "Ensemble of %d boards: %.1f board generations/s\n", n_boards, (double)n_boards * n / max_elapsed);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	if(s == n){
+		for (int b=0; b<n_boards; b++){
+			ensemble_snapshot(&boards[b], b, snap_grid, grid, num_cells, displs, xsize, my_chunk, n-1);
+		}
+	}
+
+	for (int b=0; b<n_boards; b++){
+		if (b > 0)
+			grid_free(boards[b].cells);
+		free(boards[b].top_ghost_row);
+		free(boards[b].bottom_ghost_row);
+	}
+	free(boards);
+	free(snap_grid);
+	free(l_ind_pos);
+	free(l_ind_dist);
+
+	return;
+}
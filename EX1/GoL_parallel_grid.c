@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_alloc.h"
+
+// Layout of a halo_grid: the rows (ghost rows included) follow each other at a distance of "stride" bytes.
+// In each row the first cell is at 64 bytes from the beginning of the row, so the cells of every row
+// start on a cache line, and the ghost columns are the bytes just before and just after the cells:
+//
+// 	| 63 bytes of padding | left ghost | xsize cells | right ghost | padding up to the next multiple of 64 |
+//
+// After the right ghost column there is always room to complete the last block of 64 cells of the row,
+// so the kernels for the padded rows (static_evolve_padded_row) can work only on whole vectors.
+// The ghost rows are received with MPI directly in their place, together with their ghost columns
+// (the rows are sent as xsize+2 bytes starting from the left ghost column).
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_grid_init(halo_grid *g, int xsize, int rows){
+	// Grid with a single ghost row on each side
+	halo_grid_init_deep(g, xsize, rows, 1);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_grid_init_deep(halo_grid *g, int xsize, int rows, int halo){
+
+	// Allocates the grid with halo ghost rows on each side (aligned to 64 bytes and set to 0).
+	// The rows are placed on the NUMA nodes of the omp threads that own them (see GoL_parallel_alloc.c)
+
+	g->xsize = xsize;
+	g->rows = rows;
+	g->halo = halo;
+	g->stride = 64 + ((xsize + 1 + 63) / 64) * 64;
+	g->memory = grid_alloc(rows + 2 * halo, g->stride);
+	if (g->memory == NULL){
+		fprintf(stderr, "Can't allocate a grid of %d rows with %d ghost rows on each side\n", rows, halo);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_grid_free(halo_grid *g){
+	grid_free(g->memory);
+	g->memory = NULL;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_grid_load(halo_grid *g, unsigned char *cells){
+
+	// Copies the rows of the process (xsize*rows contiguous cells) in the grid and fills their ghost columns
+
+	for (int y=0; y<g->rows; y++){
+		memcpy(halo_row(g, y), &cells[(long int)y * g->xsize], g->xsize);
+		halo_fill_columns(halo_row(g, y), g->xsize);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_grid_store(halo_grid *g, unsigned char *cells){
+
+	// Copies the rows of the process back in xsize*rows contiguous cells
+
+	for (int y=0; y<g->rows; y++){
+		memcpy(&cells[(long int)y * g->xsize], halo_row(g, y), g->xsize);
+	}
+}
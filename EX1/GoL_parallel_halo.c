@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_halo.h"
+
+// Backends of the exchange of the ghost rows. Each process sends its first row to the process above and its last row
+// to the process below, and receives its ghost rows from them (the rows are sent as xsize+2 bytes, with the ghost
+// columns). The exchange of a grid is started by halo_exchange_start and completed by halo_exchange_finish, so the
+// central rows can be evolved in between. It can also be done a boundary row at a time: halo_exchange_start_row sends
+// the first (last) row and receives the ghost row above (below) it, halo_exchange_finish_row completes them, so the
+// first row can travel while the last one is still waiting for its ghost row.
+//
+// p2p:        MPI_Isend/MPI_Irecv at each generation (tag 1 for the rows sent up, tag 0 for the rows sent down)
+// persistent: the same messages as persistent requests (MPI_Send_init/MPI_Recv_init), created once for each grid
+//             and started with MPI_Startall
+// neighbor:   MPI_Ineighbor_alltoallv on a graph topology with the two neighbours (MPI_Dist_graph_create_adjacent)
+// rma:        MPI_Put of the rows in the ghost rows of the neighbours, in a window on each grid, synchronized with
+//             post/start/complete/wait (PSCW) between the neighbours only
+//
+// The neighbor and rma backends move both rows in a single operation: with them halo_exchange_start_row starts the
+// whole exchange with the last row, and halo_exchange_finish_row completes it with the first one that is finished.
+//
+// If the windows of the rma backend can't be created (it must happen in all the processes), p2p is used.
+// The time spent in halo_exchange_start and halo_exchange_finish is reported by halo_exchange_free.
+
+#define HALO_P2P 0
+#define HALO_PERSISTENT 1
+#define HALO_NEIGHBOR 2
+#define HALO_RMA 3
+static const char *halo_backend_names[] = {"p2p", "persistent", "neighbor", "rma"};
+static int halo_backend = HALO_P2P;  // backend chosen by select_halo_backend
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+int select_halo_backend(const char *name){
+
+	// Chooses the backend by name ("p2p", "persistent", "neighbor", "rma"), NULL means p2p.
+	// Returns 0 if the backend is known and 1 otherwise (in this case p2p is used).
+
+	halo_backend = HALO_P2P;
+	if (name == NULL)
+		return 0;
+	for (int i=0; i<4; i++){
+		if (strcmp(name, halo_backend_names[i]) == 0){
+			halo_backend = i;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+const char * halo_backend_name(void){
+	return halo_backend_names[halo_backend];
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+// Offsets (from the beginning of the memory of a grid) of the rows that are exchanged, with their left ghost column
+static MPI_Aint halo_offset(halo_grid *g, int y){
+	return (MPI_Aint)(halo_row(g, y) - 1 - g->memory);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_exchange_init(halo_exchange *h, halo_grid *grids, int n_grids, int top_neighbour, int bottom_neighbour, int top_rows){
+
+	// Prepares the exchange of the ghost rows of the n_grids grids (1 or 2, with the same size) with the chosen backend
+	// (collective on MPI_COMM_WORLD). top_rows is the number of rows of the process above.
+
+	int rows = grids[0].rows;
+	int count = grids[0].xsize + 2;
+
+	h->backend = halo_backend;
+	h->grids = grids;
+	h->n_grids = n_grids;
+	h->top_neighbour = top_neighbour;
+	h->bottom_neighbour = bottom_neighbour;
+	h->top_rows = top_rows;
+	h->current[HALO_FIRST_ROW] = -1;
+	h->current[HALO_LAST_ROW] = -1;
+	h->time = 0;
+	h->exchanges = 0;
+
+	if (h->backend == HALO_PERSISTENT){
+		// The requests of the first row and of the top ghost row, then the ones of the last row and of the bottom ghost row
+		for (int g=0; g<n_grids; g++){
+			MPI_Send_init(halo_row(&grids[g], 0) - 1, count, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &h->requests[g][0]);
+			MPI_Recv_init(halo_row(&grids[g], -1) - 1, count, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &h->requests[g][1]);
+			MPI_Send_init(halo_row(&grids[g], rows - 1) - 1, count, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &h->requests[g][2]);
+			MPI_Recv_init(halo_row(&grids[g], rows) - 1, count, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &h->requests[g][3]);
+		}
+	}else if (h->backend == HALO_NEIGHBOR){
+		// The rows are sent to the bottom neighbour first and received from the top neighbour first: the messages
+		// between two processes are matched in order, so this is right also when the two neighbours are the same process
+		int sources[2] = {top_neighbour, bottom_neighbour};
+		int destinations[2] = {bottom_neighbour, top_neighbour};
+		int weights[2] = {1, 1};
+		MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD, 2, sources, weights, 2, destinations, weights, MPI_INFO_NULL, 0, &h->graph);
+	}else if (h->backend == HALO_RMA){
+		// The group of the neighbours (once, even if they are the same process)
+		MPI_Group world_group;
+		int neighbours[2] = {top_neighbour, bottom_neighbour};
+		int error = MPI_SUCCESS;
+		MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+		MPI_Group_incl(world_group, (top_neighbour == bottom_neighbour) ? 1 : 2, neighbours, &h->group);
+		MPI_Group_free(&world_group);
+		// Not every MPI library can create a window on memory it didn't allocate in every configuration
+		// (Open MPI 4 can't with a single process): in that case the exchange falls back to p2p
+		MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
+		for (int g=0; g<n_grids && error == MPI_SUCCESS; g++){
+			error = MPI_Win_create(grids[g].memory, (MPI_Aint)(rows + 2) * grids[g].stride, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &h->windows[g]);
+			if (error != MPI_SUCCESS && g == 1)
+				MPI_Win_free(&h->windows[0]);
+		}
+		MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_ARE_FATAL);
+		if (error != MPI_SUCCESS){
+			int rank;
+			MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+			if (rank == 0)
+				fprintf(stderr, "Halo backend rma not available, using p2p\n");
+			MPI_Group_free(&h->group);
+			h->backend = HALO_P2P;
+		}
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_exchange_start(halo_exchange *h, int grid){
+
+	// Starts the exchange of the ghost rows of the grid "grid" (0, or 1 with two grids). The first and last rows of the grid
+	// must not be changed, and the ghost rows must not be read, until halo_exchange_finish.
+
+	halo_exchange_start_row(h, grid, HALO_FIRST_ROW);
+	halo_exchange_start_row(h, grid, HALO_LAST_ROW);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_exchange_finish(halo_exchange *h){
+
+	// Completes the exchange in progress (if any): the ghost rows are received and the rows can be changed
+
+	halo_exchange_finish_row(h, HALO_FIRST_ROW);
+	halo_exchange_finish_row(h, HALO_LAST_ROW);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_exchange_start_row(halo_exchange *h, int grid, int row){
+
+	// Starts the exchange of a boundary row of the grid "grid": HALO_FIRST_ROW sends the first row to the process above
+	// and receives the top ghost row, HALO_LAST_ROW sends the last row to the process below and receives the bottom
+	// ghost row. The row must not be changed, and its ghost row must not be read, until halo_exchange_finish_row.
+	// With the neighbor and rma backends the whole exchange is started with the last row.
+
+	halo_grid *g = &h->grids[grid];
+	int rows = g->rows;
+	int count = g->xsize + 2;
+	double start = MPI_Wtime();
+
+	if (h->backend == HALO_P2P){
+		if (row == HALO_FIRST_ROW){
+			MPI_Isend(halo_row(g, 0) - 1, count, MPI_UNSIGNED_CHAR, h->top_neighbour, 1, MPI_COMM_WORLD, &h->requests[grid][0]);
+			MPI_Irecv(halo_row(g, -1) - 1, count, MPI_UNSIGNED_CHAR, h->top_neighbour, 0, MPI_COMM_WORLD, &h->requests[grid][1]);
+		}else{
+			MPI_Isend(halo_row(g, rows - 1) - 1, count, MPI_UNSIGNED_CHAR, h->bottom_neighbour, 0, MPI_COMM_WORLD, &h->requests[grid][2]);
+			MPI_Irecv(halo_row(g, rows) - 1, count, MPI_UNSIGNED_CHAR, h->bottom_neighbour, 1, MPI_COMM_WORLD, &h->requests[grid][3]);
+		}
+		h->current[row] = grid;
+	}else if (h->backend == HALO_PERSISTENT){
+		MPI_Startall(2, &h->requests[grid][2*row]);
+		h->current[row] = grid;
+	}else if (row == HALO_LAST_ROW){
+		if (h->backend == HALO_NEIGHBOR){
+			int counts[2] = {count, count};
+			// Last row to the bottom neighbour, first row to the top one; top ghost row first, then the bottom one
+			int send_displs[2] = {(int)halo_offset(g, rows - 1), (int)halo_offset(g, 0)};
+			int recv_displs[2] = {(int)halo_offset(g, -1), (int)halo_offset(g, rows)};
+			MPI_Ineighbor_alltoallv(g->memory, counts, send_displs, MPI_UNSIGNED_CHAR, g->memory, counts, recv_displs, MPI_UNSIGNED_CHAR, h->graph, &h->requests[grid][0]);
+		}else if (h->backend == HALO_RMA){
+			// The first row goes in the bottom ghost row of the process above, the last row in the top ghost row of the one below
+			MPI_Win_post(h->group, 0, h->windows[grid]);
+			MPI_Win_start(h->group, 0, h->windows[grid]);
+			MPI_Put(halo_row(g, 0) - 1, count, MPI_UNSIGNED_CHAR, h->top_neighbour, (MPI_Aint)(h->top_rows + 1) * g->stride + 63, count, MPI_UNSIGNED_CHAR, h->windows[grid]);
+			MPI_Put(halo_row(g, rows - 1) - 1, count, MPI_UNSIGNED_CHAR, h->bottom_neighbour, halo_offset(g, -1), count, MPI_UNSIGNED_CHAR, h->windows[grid]);
+		}
+		h->current[HALO_FIRST_ROW] = grid;
+		h->current[HALO_LAST_ROW] = grid;
+	}
+	if (row == HALO_LAST_ROW)
+		h->exchanges++;
+	h->time += MPI_Wtime() - start;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_exchange_finish_row(halo_exchange *h, int row){
+
+	// Completes the exchange of a boundary row in progress (if any): its ghost row is received and the row can be
+	// changed. With the neighbor and rma backends the whole exchange is completed.
+
+	int grid = h->current[row];
+	double start = MPI_Wtime();
+
+	if (grid < 0)
+		return;
+	if (h->backend == HALO_P2P || h->backend == HALO_PERSISTENT){
+		MPI_Waitall(2, &h->requests[grid][2*row], MPI_STATUSES_IGNORE);
+		h->current[row] = -1;
+	}else{
+		if (h->backend == HALO_NEIGHBOR){
+			MPI_Wait(&h->requests[grid][0], MPI_STATUS_IGNORE);
+		}else if (h->backend == HALO_RMA){
+			MPI_Win_complete(h->windows[grid]);
+			MPI_Win_wait(h->windows[grid]);
+		}
+		h->current[HALO_FIRST_ROW] = -1;
+		h->current[HALO_LAST_ROW] = -1;
+	}
+	h->time += MPI_Wtime() - start;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void halo_exchange_free(halo_exchange *h){
+
+	// Completes the exchange in progress, reports (process 0, on stderr) the mean time of an exchange of the slowest
+	// process and frees the resources of the backend (collective on MPI_COMM_WORLD)
+
+	int rank;
+	double mean, max_mean;
+
+	halo_exchange_finish(h);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	mean = (h->exchanges > 0) ? h->time / h->exchanges : 0;
+	MPI_Reduce(&mean, &max_mean, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if (rank == 0){
+		fprintf(stderr, "Halo exchange (%s): %.3f ms per generation\n", halo_backend_names[h->backend], max_mean * 1e3);
+	}
+
+	if (h->backend == HALO_PERSISTENT){
+		for (int g=0; g<h->n_grids; g++){
+			for (int i=0; i<4; i++){
+				MPI_Request_free(&h->requests[g][i]);
+			}
+		}
+	}else if (h->backend == HALO_NEIGHBOR){
+		MPI_Comm_free(&h->graph);
+	}else if (h->backend == HALO_RMA){
+		for (int g=0; g<h->n_grids; g++){
+			MPI_Win_free(&h->windows[g]);
+		}
+		MPI_Group_free(&h->group);
+	}
+}
@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+
+// Hashlife: the grid is stored as a quadtree where equal squares are the same node (a hash table gives the
+// canonical node for its four children), and the evolution of each node is memoized.
+// A node of level L is a square of 2^L x 2^L cells (level 0 nodes are the cells). Its evolution is the square
+// of level L-1 at its center, after 2^j generations (j <= L-2, since the state of a cell depends only on the cells
+// at distance up to the number of generations).
+//
+// The nodes are in an array and they refer to each other with their position in the array (the array can be
+// reallocated while it grows). The positions 0 and 1 are the dead and the alive cell.
+
+#define HL_MAX_NODES (1 << 24)  // Above this number of nodes the tables are cleared between two steps
+
+typedef struct {
+	uint32_t nw, ne, sw, se;  // children (top left, top right, bottom left, bottom right)
+	uint32_t next;            // next node in the same bucket of the hash table
+	int level;
+} hl_node;
+
+static hl_node *nodes = NULL;
+static uint32_t n_nodes, nodes_size;
+static uint32_t *buckets = NULL;  // first node of each bucket of the hash table (0 means empty, the dead cell is never in the table)
+static uint32_t n_buckets;
+
+// Memoized evolutions: the key is (node << 6) + j, the value is the result
+static uint64_t *cache_keys = NULL;
+static uint32_t *cache_values = NULL;
+static uint64_t n_cached, cache_size;
+
+static uint32_t empty[64];  // empty node of each level
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static uint64_t hl_hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se){
+	uint64_t h = nw;
+	h = h * 0x9E3779B97F4A7C15ULL + ne;
+	h = h * 0x9E3779B97F4A7C15ULL + sw;
+	h = h * 0x9E3779B97F4A7C15ULL + se;
+	return h ^ (h >> 29);
+}
+
+static void hl_rehash(void){
+
+	// Doubles the number of buckets of the node table
+
+	n_buckets *= 2;
+	free(buckets);
+	buckets = (uint32_t *)calloc(n_buckets, sizeof(uint32_t));
+	for (uint32_t p=2; p<n_nodes; p++){
+		uint64_t b = hl_hash(nodes[p].nw, nodes[p].ne, nodes[p].sw, nodes[p].se) & (n_buckets - 1);
+		nodes[p].next = buckets[b];
+		buckets[b] = p;
+	}
+}
+
+static uint32_t hl_find_node(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se){
+
+	// Returns the canonical node with these children (creating it if needed)
+
+	uint64_t b = hl_hash(nw, ne, sw, se) & (n_buckets - 1);
+	for (uint32_t p=buckets[b]; p!=0; p=nodes[p].next){
+		if (nodes[p].nw == nw && nodes[p].ne == ne && nodes[p].sw == sw && nodes[p].se == se)
+			return p;
+	}
+	if (n_nodes == nodes_size){
+		nodes_size *= 2;
+		nodes = (hl_node *)realloc(nodes, nodes_size * sizeof(hl_node));
+	}
+	uint32_t p = n_nodes++;
+	nodes[p].nw = nw;
+	nodes[p].ne = ne;
+	nodes[p].sw = sw;
+	nodes[p].se = se;
+	nodes[p].level = nodes[nw].level + 1;
+	nodes[p].next = buckets[b];
+	buckets[b] = p;
+	if (n_nodes > n_buckets)
+		hl_rehash();
+	return p;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static uint64_t hl_cache_slot(uint64_t key){
+	// Position of the key in the cache (or of the empty slot where it should go)
+	uint64_t i = (key * 0x9E3779B97F4A7C15ULL >> 17) & (cache_size - 1);
+	while (cache_keys[i] != UINT64_MAX && cache_keys[i] != key)
+		i = (i + 1) & (cache_size - 1);
+	return i;
+}
+
+static void hl_cache_insert(uint64_t key, uint32_t value){
+
+	// Adds a result to the cache (open addressing, doubled when half full)
+
+	if (2 * (n_cached + 1) > cache_size){
+		uint64_t *old_keys = cache_keys;
+		uint32_t *old_values = cache_values;
+		uint64_t old_size = cache_size;
+		cache_size *= 2;
+		cache_keys = (uint64_t *)malloc(cache_size * sizeof(uint64_t));
+		cache_values = (uint32_t *)malloc(cache_size * sizeof(uint32_t));
+		memset(cache_keys, 0xFF, cache_size * sizeof(uint64_t));
+		for (uint64_t i=0; i<old_size; i++){
+			if (old_keys[i] != UINT64_MAX){
+				uint64_t slot = hl_cache_slot(old_keys[i]);
+				cache_keys[slot] = old_keys[i];
+				cache_values[slot] = old_values[i];
+			}
+		}
+		free(old_keys);
+		free(old_values);
+	}
+	uint64_t slot = hl_cache_slot(key);
+	cache_keys[slot] = key;
+	cache_values[slot] = value;
+	n_cached++;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void hl_init(void){
+
+	// Creates the tables with only the two cells and the empty nodes
+
+	nodes_size = 1 << 16;
+	nodes = (hl_node *)malloc(nodes_size * sizeof(hl_node));
+	n_buckets = 1 << 16;
+	buckets = (uint32_t *)calloc(n_buckets, sizeof(uint32_t));
+	for (uint32_t p=0; p<2; p++){
+		nodes[p].nw = nodes[p].ne = nodes[p].sw = nodes[p].se = 0;
+		nodes[p].next = 0;
+		nodes[p].level = 0;
+	}
+	n_nodes = 2;
+
+	cache_size = 1 << 16;
+	cache_keys = (uint64_t *)malloc(cache_size * sizeof(uint64_t));
+	cache_values = (uint32_t *)malloc(cache_size * sizeof(uint32_t));
+	memset(cache_keys, 0xFF, cache_size * sizeof(uint64_t));
+	n_cached = 0;
+
+	empty[0] = 0;
+	for (int l=1; l<64; l++){
+		empty[l] = hl_find_node(empty[l-1], empty[l-1], empty[l-1], empty[l-1]);
+	}
+}
+
+static void hl_free(void){
+	if (nodes != NULL)
+		free(nodes);
+	if (buckets != NULL)
+		free(buckets);
+	if (cache_keys != NULL)
+		free(cache_keys);
+	if (cache_values != NULL)
+		free(cache_values);
+	nodes = NULL;
+	buckets = NULL;
+	cache_keys = NULL;
+	cache_values = NULL;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static uint32_t hl_center(uint32_t p){
+	// Square of level L-1 at the center of the node
+	return hl_find_node(nodes[nodes[p].nw].se, nodes[nodes[p].ne].sw, nodes[nodes[p].sw].ne, nodes[nodes[p].se].nw);
+}
+
+static uint32_t hl_horizontal(uint32_t w, uint32_t e){
+	// Square of level L between the nodes w and e (of level L, side by side)
+	return hl_find_node(nodes[w].ne, nodes[e].nw, nodes[w].se, nodes[e].sw);
+}
+
+static uint32_t hl_vertical(uint32_t n, uint32_t s){
+	// Square of level L between the nodes n and s (of level L, one above the other)
+	return hl_find_node(nodes[n].sw, nodes[n].se, nodes[s].nw, nodes[s].ne);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static uint32_t hl_base(uint32_t p){
+
+	// Evolution of a node of level 2 (4x4 cells) by one generation: the 2x2 cells at the center
+
+	int cell[4][4];  // cell[y][x]
+	uint32_t quad[2][2] = {{nodes[p].nw, nodes[p].ne}, {nodes[p].sw, nodes[p].se}};
+	uint32_t q;
+	int nei, alive[2][2];
+
+	for (int qy=0; qy<2; qy++){
+		for (int qx=0; qx<2; qx++){
+			q = quad[qy][qx];
+			cell[2*qy][2*qx] = nodes[q].nw;
+			cell[2*qy][2*qx+1] = nodes[q].ne;
+			cell[2*qy+1][2*qx] = nodes[q].sw;
+			cell[2*qy+1][2*qx+1] = nodes[q].se;
+		}
+	}
+	for (int y=1; y<3; y++){
+		for (int x=1; x<3; x++){
+			nei = cell[y-1][x-1] + cell[y-1][x] + cell[y-1][x+1] + cell[y][x-1] + cell[y][x+1] + cell[y+1][x-1] + cell[y+1][x] + cell[y+1][x+1];
+			alive[y-1][x-1] = RULE_NEW_STATE(cell[y][x], nei);
+		}
+	}
+	return hl_find_node(alive[0][0], alive[0][1], alive[1][0], alive[1][1]);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static uint32_t hl_advance(uint32_t p, int j){
+
+	// Returns the square of level L-1 at the center of the node p (of level L), after 2^j generations (j <= L-2).
+	// The node is divided in 9 overlapping squares of level L-1. If j = L-2 each of them is evolved by 2^(L-3)
+	// generations, and the 4 squares of level L-1 formed by the results are evolved by other 2^(L-3) generations.
+	// Otherwise the 9 squares are only reduced to their center, and the 4 squares are evolved by 2^j generations.
+
+	int level = nodes[p].level;
+	uint64_t key = ((uint64_t)p << 6) + j;
+	uint64_t slot = hl_cache_slot(key);
+	if (cache_keys[slot] == key)
+		return cache_values[slot];
+
+	// An empty square stays empty (if the rule doesn't give birth to cells without neighbours)
+	if (p == empty[level] && !(rule_birth & 1))
+		return empty[level-1];
+
+	uint32_t result;
+	if (level == 2){
+		result = hl_base(p);
+	}else{
+		uint32_t nw = nodes[p].nw, ne = nodes[p].ne, sw = nodes[p].sw, se = nodes[p].se;
+		uint32_t sq[3][3];  // the 9 squares of level L-1
+		uint32_t r[3][3];   // the 9 squares of level L-2
+		uint32_t q[2][2];   // the 4 results of level L-2
+
+		sq[0][0] = nw;
+		sq[0][1] = hl_horizontal(nw, ne);
+		sq[0][2] = ne;
+		sq[1][0] = hl_vertical(nw, sw);
+		sq[1][1] = hl_center(p);
+		sq[1][2] = hl_vertical(ne, se);
+		sq[2][0] = sw;
+		sq[2][1] = hl_horizontal(sw, se);
+		sq[2][2] = se;
+
+		for (int y=0; y<3; y++){
+			for (int x=0; x<3; x++){
+				r[y][x] = (j == level-2) ? hl_advance(sq[y][x], j-1) : hl_center(sq[y][x]);
+			}
+		}
+		for (int y=0; y<2; y++){
+			for (int x=0; x<2; x++){
+				uint32_t square = hl_find_node(r[y][x], r[y][x+1], r[y+1][x], r[y+1][x+1]);
+				q[y][x] = hl_advance(square, (j == level-2) ? j-1 : j);
+			}
+		}
+		result = hl_find_node(q[0][0], q[0][1], q[1][0], q[1][1]);
+	}
+	hl_cache_insert(key, result);
+	return result;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static uint32_t hl_build(unsigned char *grid, int xsize, int level, long int x, long int y, long int offset){
+
+	// Node of the given level with the top left cell in (x, y) of the infinite plane obtained repeating the grid
+	// (torus). The cell (x, y) of the plane is the cell (x-offset, y-offset) of the grid.
+
+	if (level == 0){
+		long int gx = ((x - offset) % xsize + xsize) % xsize;
+		long int gy = ((y - offset) % xsize + xsize) % xsize;
+		return (grid[gy * xsize + gx] != 0);
+	}
+	long int half = 1L << (level - 1);
+	uint32_t nw = hl_build(grid, xsize, level-1, x, y, offset);
+	uint32_t ne = hl_build(grid, xsize, level-1, x + half, y, offset);
+	uint32_t sw = hl_build(grid, xsize, level-1, x, y + half, offset);
+	uint32_t se = hl_build(grid, xsize, level-1, x + half, y + half, offset);
+	return hl_find_node(nw, ne, sw, se);
+}
+
+static void hl_extract(uint32_t p, unsigned char *grid, int xsize, long int x, long int y){
+
+	// Writes in the grid the cells of the node p (with the top left cell in (x, y)) that are inside the grid
+
+	int level = nodes[p].level;
+	if (x >= xsize || y >= xsize)
+		return;
+	if (level == 0){
+		grid[y * xsize + x] = (unsigned char)p;
+		return;
+	}
+	long int half = 1L << (level - 1);
+	if (p == empty[level]){
+		for (long int yy=y; yy<y+2*half && yy<xsize; yy++){
+			for (long int xx=x; xx<x+2*half && xx<xsize; xx++){
+				grid[yy * xsize + xx] = 0;
+			}
+		}
+		return;
+	}
+	uint32_t nw = nodes[p].nw, ne = nodes[p].ne, sw = nodes[p].sw, se = nodes[p].se;
+	hl_extract(nw, grid, xsize, x, y);
+	hl_extract(ne, grid, xsize, x + half, y);
+	hl_extract(sw, grid, xsize, x, y + half);
+	hl_extract(se, grid, xsize, x + half, y + half);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void hl_step(unsigned char *grid, int xsize, int min_level, int log_size, int j){
+
+	// Evolves the grid (torus) by 2^j generations.
+	// The node evolved must be of level L >= j+2, and its center (of level L-1) must contain the whole grid.
+	// Its top left cell is placed in (-2^(L-2), -2^(L-2)) of the plane, so that the center starts in (0, 0).
+	// If the size of the grid is a power of 2 (2^log_size) and 2^(L-2) is a multiple of it, the node is made of
+	// equal copies of the grid, so it's built from the node of the grid with log_size levels of repeated children.
+	// Otherwise the node is built cell by cell (this requires L = min_level, the smallest level that contains
+	// the grid, so j <= min_level-2).
+
+	int level = (j + 2 > min_level) ? j + 2 : min_level;
+	uint32_t universe;
+
+	if (log_size >= 0 && level - 2 >= log_size){
+		universe = hl_build(grid, xsize, log_size, 0, 0, 0);
+		for (int l=log_size; l<level; l++){
+			universe = hl_find_node(universe, universe, universe, universe);
+		}
+	}else{
+		universe = hl_build(grid, xsize, level, 0, 0, 1L << (level - 2));
+	}
+	hl_extract(hl_advance(universe, j), grid, xsize, 0, 0);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void hashlife_evolution(unsigned char *grid, int xsize, int n, int s) {
+
+	// Evolution with the hashlife algorithm (the rules and the snapshots are the ones of the static evolution).
+	// The algorithm is serial, so only the process 0 (which has the whole grid after the reading) works.
+	// The grid is a torus: the quadtree represents a square of the infinite plane obtained repeating the grid.
+	// The evolution jumps from a snapshot to the next one with steps of 2^j generations (the largest ones
+	// possible). When the tables become too large they are cleared between two steps (the state is in the grid).
+
+	int rank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+
+	if (rank == 0){
+
+		// Smallest level with the center (of level L-1) that contains the grid
+		int min_level = 2;
+		while ((1L << (min_level - 1)) < xsize)
+			min_level++;
+		// Size of the grid as a power of 2 (-1 if it's not a power of 2)
+		int log_size = -1;
+		if ((xsize & (xsize - 1)) == 0){
+			log_size = 0;
+			while ((1 << log_size) < xsize)
+				log_size++;
+		}
+
+		int gen = 0;
+		int target, remaining, j;
+		int steps = 0;
+		uint32_t max_nodes = 0;
+
+		// As in static_evolution, the final snapshot labelled n has the state of the generation n-1
+		int last = (s == n) ? n - 1 : n;
+
+		hl_init();
+
+		while (gen < last){
+
+			// Writing the snapshot file (with the state of the current generation)
+			if((gen % s == 0) && (s != n)){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_hashlife/snapshot", gen);
+			}
+
+			// Generation of the next snapshot (or the end)
+			target = (s != n) ? (gen / s + 1) * s : last;
+			if (target > last)
+				target = last;
+
+			while (gen < target){
+				// Largest power of 2 that fits in the remaining generations
+				remaining = target - gen;
+				j = 0;
+				while ((2L << j) <= remaining)
+					j++;
+				if (log_size < 0 && j > min_level - 2)
+					j = min_level - 2;
+
+				hl_step(grid, xsize, min_level, log_size, j);
+				gen += 1 << j;
+				steps++;
+
+				if (n_nodes > max_nodes)
+					max_nodes = n_nodes;
+				// Clearing the tables
+				if (n_nodes > HL_MAX_NODES){
+					hl_free();
+					hl_init();
+				}
+			}
+		}
+
+		// Writing the snapshot file with the final state
+		if(s == n){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_hashlife/snapshot", n);
+		}
+
+		// Printing the statistics (on stderr, to keep the timing output clean)
+		fprintf(stderr, "Hashlife: %d steps, up to %u nodes\n", steps, max_nodes);
+
+		hl_free();
+	}
+
+	// Waiting for the process 0 before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	return;
+}
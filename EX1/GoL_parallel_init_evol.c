@@ -5,6 +5,9 @@
 #include <string.h>
 #include "mpi.h"
 #include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_halo.h"
 #include <omp.h>
 
 char *  init_playground(unsigned long int n_cells){
@@ -51,43 +54,41 @@ void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cell
 	// Applies the static evolution on the portion of the grid given to the MPI process.
 	// To increase the efficiency only a single grid of chars is used and the state of
 	// a single cell is stored in alternating positions between bit 1 and bit 2.
-	// To simplify branch redictions a minimal number of if cases are used. Most operations just use boolean logic.
-	// To indicate where the nighbouring cells are located in the grid (since they might be on the edge of it) some
-	// variables like left_move and right_move are used, this is to avoid the use of if cases.
+	// The rows are kept in a halo grid (see GoL_parallel_grid.c): the ghost rows and the ghost columns
+	// are in the same allocation of the rows, so the first, the last and the central rows are all evolved by the
+	// same branch-free kernel (static_evolve_padded_row). The wrap on the columns is done once per row,
+	// copying the first and the last cell in the ghost columns after the row is evolved.
+	// The rows are sent with their ghost columns, and the ghost rows are received directly in the halo grid, by the
+	// backend of the halo exchange chosen with -x (see GoL_parallel_halo.c).
 	//
 	// To reduce the waiting time to send and receive the upper/bottom row, the following MPI structure is used:
 	
 	// MPI communications stucture:
 	//
-	// Wait(sendfirst, recvtop)
+	// halo_exchange_finish_row(first row)
 	// 	First row
-	// isend/irecv(sendfirst, recvtop)
-	// Wait(sendlast, recvbottom)
+	// halo_exchange_start_row(first row)
+	// halo_exchange_finish_row(last row)
 	//	Last row
-	// isend/irecv(sendlast, recvbottom)
+	// halo_exchange_start_row(last row)
 	// 	Central rows
 	// Writing snapshots	
 	
-	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
-	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	halo_grid halo;
+	halo_grid_init(&halo, xsize, my_chunk);
+	halo_grid_load(&halo, my_grid);
 	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
 
+	// Rows evolved with the ghost rows
+	unsigned char *top_ghost_row = halo_row(&halo, -1);
+	unsigned char *first_row = halo_row(&halo, 0);
+	unsigned char *last_row = halo_row(&halo, my_chunk - 1);
+	unsigned char *bottom_ghost_row = halo_row(&halo, my_chunk);
 
 	// Alternating positions of the current and next states of the system
 	char current;
 	char next;
 
-	char nei; // number of live neighbours
-	char my_current;  // current state of the cell
-			
-	// This will help in the computation of neighbuouring cells
-	int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
-	int right_move;   // right_move = +1 - (xsize if x == xsize-1). This will make it go down a row if on the right border
-	int up_move = -xsize;      // This will make it go up a row (There's no way of looping back to the top row because we use ghost rows)
-	int down_move = xsize;     // This will make it go down a row
-	int pos;          // pos = y*xsize + x.   Current position
-	int stride = 128;  // chunk size for omp
-
 	int rank, size;
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
 	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
@@ -95,18 +96,10 @@ void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cell
 	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
 	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
 	
-	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
-	
-	// Sharing the ghost rows to start the generations
-	
-	// Each process sends its top row to its top neighbour
-	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
-	// Each process sends its bottom row to its bottom neighbour
-	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
-	// Each process receives its bottom ghost row from its bottom neighbour
-	MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
-	// Each process receives its top ghost row from its top neighbour
-	MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0,MPI_COMM_WORLD, &recvtop);
+	// Sharing the ghost rows to start the generations (the grid is evolved in place, so there is a single grid)
+	halo_exchange exchange;
+	halo_exchange_init(&exchange, &halo, 1, top_neighbour, bottom_neighbour, num_cells[top_neighbour] / xsize);
+	halo_exchange_start(&exchange, 0);
 	
 	//MPI_Barrier(MPI_COMM_WORLD);
 
@@ -119,133 +112,49 @@ void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cell
 		next = 2 - gen % 2;
 		
 		// waiting for the operations on the first row
-		MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
-		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
-		
-		MPI_Request sendfirst, recvtop; // Handles for the non blocking comm.
+		halo_exchange_finish_row(&exchange, HALO_FIRST_ROW);
+		// If the process has a single row, the row below the first one is the bottom ghost row
+		if (my_chunk == 1){
+			halo_exchange_finish_row(&exchange, HALO_LAST_ROW);
+		}
 		
 		// Update the first and last line as soon as they come
-		// The parallel evolution of the border rows is done by dividing them in 
-		// chunks of size "stride" to avoid working on the same cache line.
-		// (stride = 2 * length_cache_line)
-		
-		// Parallel evolution on the first row
-		#pragma omp parallel for schedule( static, stride ) private(left_move, right_move, nei, my_current)
-		for(int x=0; x<xsize; x++){
-			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
-			right_move = +1 - (xsize * (x == xsize-1)); //This will make it go down a row if on the right border
-			
-			nei = 0;
-			// The state of the cell in this generation is stored in the same bit as the "1" bit in current_state (first or second)
-			nei += top_ghost_row[x + left_move] & current;
-			nei += top_ghost_row[x] & current;
-			nei += top_ghost_row[x + right_move] & current;
-			nei += my_grid[x + left_move] & current;
-			nei += my_grid[x + right_move] & current;
-			nei += my_grid[x + down_move + left_move] & current;
-			nei += my_grid[x + down_move] & current;
-			nei += my_grid[x + down_move + right_move] & current;
-			nei >>= (current -1); // rescaling the value of nei (if current = 2 then nei is stored starting from the second bit)
-			
-			my_current = current & my_grid[x];
-			my_grid[x] = my_current + next * (  (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3))  );
-			// This is done to preserve the current state and modify the next state (they are located on different bits)
-			// Explaination: the "next" bit will be one only if the cell is born or nothing happens on a live cell
-				
-		}
-		// Sending the fist line. The tag is 1
-		MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
-		// Receving the new top_ghost_row. The tag is 0
-		MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+		static_evolve_padded_row(top_ghost_row, first_row, halo_row(&halo, 1), xsize, current, next);
+		halo_fill_columns(first_row, xsize);
+
+		// Sending the first line, receiving the new top ghost row
+		halo_exchange_start_row(&exchange, 0, HALO_FIRST_ROW);
 		
 		// Waiting for the operations on the last row
-		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
-		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);	
-		
-		//MPI_Request sendlast, recvbottom;
+		halo_exchange_finish_row(&exchange, HALO_LAST_ROW);
 		
-		// Parallel evolution on the last row
-		#pragma omp parallel for schedule( static, stride ) private(left_move, right_move, pos,  nei, my_current)
-		for(int x=0; x<xsize; x++){
-			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
-			right_move = +1 - (xsize * (x == xsize-1)); //This will make it go down a row if on the right border
-			
-			pos = (my_chunk - 1)*xsize + x;   //Current position
-			
-			nei = 0;
-			
-			nei += my_grid[pos + up_move + left_move] & current;
-			nei += my_grid[pos + up_move] & current;
-			nei += my_grid[pos + up_move + right_move] & current;
-			nei += my_grid[pos + left_move] & current;
-			nei += my_grid[pos + right_move] & current;
-			nei += bottom_ghost_row[x + left_move] & current;
-			nei += bottom_ghost_row[x] & current;
-			nei += bottom_ghost_row[x + right_move] & current;
-			nei >>= (current -1); // rescaling the value of nei (if current = 2 then nei is stored starting from the second bit)
-			
-			my_current = current & my_grid[pos];
-			my_grid[pos] = my_current + next * (  (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3))  );
+		// Evolution of the last row (if it's not also the first one)
+		if (my_chunk > 1){
+			static_evolve_padded_row(halo_row(&halo, my_chunk - 2), last_row, bottom_ghost_row, xsize, current, next);
+			halo_fill_columns(last_row, xsize);
 		}
-		// Sending the last row. The tag is 0
-		MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
-		// Receving the new bottom_ghost_row. The tag is 1
-		MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+		// Sending the last line, receiving the new bottom ghost row
+		halo_exchange_start_row(&exchange, 0, HALO_LAST_ROW);
 		
 		
 		// Parallel evolution of the central rows.
 		// The work on rows is shared between omp threads.
-		// Each thread will (ideally) work on at least 3 rows at each time, so
-		// that (hopefully) there won't be any false sharing between threads.
-		#pragma omp parallel for schedule( guided, 3 ) private(left_move, right_move, pos, nei, my_current)
+		// Each thread works on a single band of rows (schedule( static )), the one whose pages it
+		// placed on its NUMA node with the first touch in grid_alloc.
+		#pragma omp parallel for schedule( static )
 		for(int y=1; y<my_chunk-1; y++){
-		
-			for(int x=0; x<xsize; x++){
-				
-				left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
-				right_move = +1 - (xsize * (x == xsize-1)); //This will make it go down a row if on the right border
-				
-				pos = y*xsize + x;   //Current position
-				
-				nei = 0;
-				
-				nei += my_grid[pos + up_move + left_move] & current;
-				nei += my_grid[pos + up_move] & current;
-				nei += my_grid[pos + up_move + right_move] & current;
-				nei += my_grid[pos + left_move] & current;
-				nei += my_grid[pos + right_move] & current;
-				nei += my_grid[pos + down_move + left_move] & current;
-				nei += my_grid[pos + down_move] & current;
-				nei += my_grid[pos + down_move + right_move] & current;
-				nei >>= (current -1); // rescaling the value of nei (if current = 2 then nei is stored starting from the second bit)
-				
-				//
-				//if (!(my_grid[pos] & current) && nei == 3) {           // if the cell is born
-				//	my_grid[pos] |= next;
-				//} else if ((my_grid[pos] & current) && !(nei == 2 || nei == 3)){     // if the cell dies
-				//	my_grid[pos] &= current;			     
-				//	// this is a trick to change the next state to zero while maintaining the current state intact
-				//}else{      // if the cell stays the same
-				//	my_grid[pos]  = 3 * ((my_grid[pos] & current) == current);	// this is a trick to have them both
-				//										// equal to 1 (state 3) or to 0 (if the
-				//										// multiplication gives 0)
-				//}
-				
-				//REWITTEN IN A FASTER WAY (without if jumps):
-				
-				my_current = current & my_grid[pos];
-				my_grid[pos] = my_current + next * (  (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3))  );
-				//this is done to preserve the current state and modify the next state (they are located on different bits)
-				//explaination: the "next" bit will be one only if the cell is born or nothing happens on a live cell
-			}
+			static_evolve_padded_row(halo_row(&halo, y-1), halo_row(&halo, y), halo_row(&halo, y+1), xsize, current, next);
+			halo_fill_columns(halo_row(&halo, y), xsize);
 		}// end omp parallel
 		
 		// Writing the snapshot file
 		if((gen % s == 0) && (s != n)){
 			//writing the temporary grid
-			for (int i=0; i<xsize*my_chunk; i++){
-				//snap_grid will have the value of the grid at the current state
-				snap_grid[i] = ((my_grid[i] & current) == current);
+			for (int y=0; y<my_chunk; y++){
+				for (int x=0; x<xsize; x++){
+					//snap_grid will have the value of the grid at the current state
+					snap_grid[y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+				}
 			}
 			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
 			if (rank == 0){	
@@ -256,28 +165,20 @@ void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cell
 				
 	} // End cycle on gen
 	
-	// Deallocating all the handles
-	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
-	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
-	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
-       	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+	// Completing the last exchange and deallocating the handles
+	halo_exchange_free(&exchange);
 	
 	// Waiting for all processes before ending
 	MPI_Barrier(MPI_COMM_WORLD);
 
-	if (top_ghost_row != NULL){
-		free(top_ghost_row);
-	}
-
-	if (bottom_ghost_row != NULL)
-		free(bottom_ghost_row);
-
 	// Writing the snapshot file
 	if(s == n){
 		//writing the temporary grid
-		for (int i=0; i<xsize*my_chunk; i++){
-			//snap_grid will have the value of the grid at the current state
-			snap_grid[i] = ((my_grid[i] & current) == current);
+		for (int y=0; y<my_chunk; y++){
+			for (int x=0; x<xsize; x++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+			}
 		}
 		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
 		if (rank == 0){		
@@ -288,6 +189,10 @@ void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cell
 	if (snap_grid != NULL)
 		free(snap_grid);
 
+	// The process keeps its rows in my_grid
+	halo_grid_store(&halo, my_grid);
+	halo_grid_free(&halo);
+
 	return;
 }
 
@@ -295,17 +200,29 @@ void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cell
 
 // ######################################################################################################################################
 
+int l_ind_point(unsigned char val){
+	// 1 if the cell with the value val (encoding of ordered_evolution) is a line_independent point with the rule of
+	// the evolution: its new state is the same whether or not the cell on its left changes state before it.
+	// That cell is alive if prev is 1, so its change can only take one neighbour away (or add one if prev is 0).
+	int nei = val >> 2;
+	int prev = (val >> 1) & 1;
+	int state = val & 1;
+	if (prev && nei == 0)
+		return 0;  // not a valid value
+	return RULE_NEW_STATE(state, nei) == RULE_NEW_STATE(state, prev ? nei - 1 : nei + 1);
+}
+
 int l_ind(unsigned char *my_grid, int y, int xsize, int stride, int *l_ind_pos, int *l_ind_dist){
         // Creates the arrays of the line_independent points and the number count
         char val, check;
         int i = stride -1; // starting position
-        int dist = stride; // starting distance
+        int dist = stride - 1; // starting distance (the first fragment ends before the starting position)
         int count = 1;
         l_ind_pos[0] = 0; // makes sure that the first l_ind cell is the first one
         while (i<xsize){
                 val = my_grid[(y+1)*xsize + i]; // value of the cell in the following line for x = i
                 // Checking if the cell is a l_ind point
-                check = (val<4) || (val>19) || (val==9) || (val==15) || (val==7) || (val==17) || (val==4) || (val==6) || (val==10) || (val==16);
+                check = l_ind_point(val);
                 if (check){
                         l_ind_pos[count] = i;
                         l_ind_dist[count-1] = dist;
@@ -327,6 +244,296 @@ int l_ind(unsigned char *my_grid, int y, int xsize, int stride, int *l_ind_pos,
 
 // ######################################################################################################################################
 
+// Steps of ordered_evolution on the grid of a process (xsize*my_chunk cells), shared with the other ordered engines.
+// The cells use the encoding of ordered_evolution: nei*4 + prev*2 + state.
+
+void ordered_encode(unsigned char *my_grid, int xsize, int my_chunk, unsigned char *top_ghost_row, unsigned char *bottom_ghost_row){
+
+	// Initializing the grid to get the right value of prev and nei for all cells (the state is in the first bit)
+
+	char prev; // Will be 1 if the previous cell is alive and 0 otherwise
+	char nei; // Number of alive neighbours
+	int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
+	int right_move;   // right_move = +1 - (xsize if x == xsize-1). This will make it go down a row if on the right border
+	int pos;          // pos = y*xsize + x.   Current position
+
+	for (int y = 0; y<my_chunk; y++){
+		for (int x = 0; x<xsize; x++){
+		
+			pos = y*xsize + x;   //Current position
+			nei = 0;
+			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
+			right_move = +1 - (xsize * (x == xsize-1)); //This will make it go down a row if on the right border
+			
+			//computing the number of neighbours
+			if (y==0){  // Using the top_ghost_row
+				nei+=top_ghost_row[x + left_move] & 1; //  & 1 will give the value of the first bit
+				nei+=top_ghost_row[x] & 1;
+				nei+=top_ghost_row[x + right_move] & 1;
+			}else{
+				nei+=my_grid[pos - xsize + left_move] & 1;
+				nei+=my_grid[pos - xsize] & 1;
+				nei+=my_grid[pos - xsize + right_move] & 1;
+			}
+			nei+=my_grid[pos + left_move] & 1;
+			nei+=my_grid[pos + right_move] & 1;
+			if (y==my_chunk-1){  // Using the bottom_ghost_row
+				nei+=bottom_ghost_row[x + left_move] & 1;
+				nei+=bottom_ghost_row[x] & 1;
+				nei+=bottom_ghost_row[x + right_move] & 1;
+			}else{
+				nei+=my_grid[pos + xsize + left_move] & 1;
+				nei+=my_grid[pos + xsize] & 1;
+				nei+=my_grid[pos + xsize + right_move] & 1;
+			}
+			//computing prev
+			if (pos!=0){
+				prev = my_grid[pos -1] & 1;
+			}else{
+				prev = 0;
+			}
+			// the value of each cell will encode its state, the previous cell state and the live neighbours
+			my_grid[pos] = (nei*4) + (prev*2) + (my_grid[pos] & 1);
+		}	
+	} // The grid is initialized with the right encoding
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void ordered_first_row(unsigned char *my_grid, unsigned char *top_ghost_row, int xsize){
+
+	// Updating the first line (no parallelization). The neighbours above are read from the top ghost row
+
+	char prev, nei, diff;
+	char my_current, my_new;
+	int left_move, right_move;
+	int down_move = xsize;     // This will make it go down a row
+	int pos;
+
+	for (int x = 0; x < xsize; x++){
+		
+		pos = x;   //Current position
+		nei = 0;
+		left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
+		right_move = +1 - (xsize * (x == (xsize-1))); //This will make it go down a row if on the right border
+		// computing the number of neighbours
+		nei+=top_ghost_row[x + left_move] & 1;
+		nei+=top_ghost_row[x] & 1;
+		nei+=top_ghost_row[x + right_move] & 1;
+		nei+=my_grid[pos + left_move] & 1;
+		nei+=my_grid[pos + right_move] & 1;
+		nei+=my_grid[pos + down_move + left_move] & 1;
+		nei+=my_grid[pos + down_move] & 1;
+		nei+=my_grid[pos + down_move + right_move] & 1;
+		// computing prev 
+		if (pos!=0){
+			prev = my_grid[pos -1] & 1;
+		}else{
+			prev = 0;
+		}
+		// Evolving the state
+		my_current = my_grid[pos] & 1;
+		my_new = RULE_NEW_STATE(my_current, nei); // Evaluates the new state of the grid
+		diff = my_new - my_current;
+		my_grid[pos] = (nei*4) + (prev*2) + my_new;
+		// Updating the value of prev in the next cell 
+		my_grid[pos + 1] += diff*2; // The value of the second bit will increase or decrease by one
+		// Updating the value nei in the other cells
+		my_grid[pos + left_move]              += diff*4;
+		my_grid[pos + down_move + left_move]  += diff*4; // nei is stored starting from the third bit, it will 
+		my_grid[pos + down_move]              += diff*4; // increase or decrease by one
+		my_grid[pos + down_move + right_move] += diff*4;
+		if (x == xsize-1){
+			my_grid[pos + right_move]     += diff*4;
+		}
+	}// end of work on the first line
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void ordered_fragment(unsigned char *my_grid, int y, int xsize, int start, int dist, int first){
+
+	// Updating a fragment of a central row: the cells from x = start to start+dist-1. The first cell is a l_ind point,
+	// or the first cell of the row if first is 1 (only this one passes its change to the cell on its left).
+	// The fragments of a row can be evolved in parallel, then ordered_fix_fragments must be called.
+
+	char val;
+	char diff;
+	char prev, nei;
+	char my_current, my_new;
+	int left_move, right_move;
+	int up_move = -xsize;      // This will make it go up a row
+	int down_move = xsize;     // This will make it go down a row
+	int pos;
+	uint64_t todo;     // cells of a block of 64 that must still be evolved (bit i for the cell i of the block)
+	int changed;       // 1 if the last cell of the previous block changed state
+	int block_size;    // cells in the block (64, or less at the end of the fragment)
+	int end = y*xsize + start + dist;  // position after the last cell of the fragment
+
+	// Updating the first element
+	
+	pos = y*xsize + start;
+	left_move = -1 + (xsize * ((pos%xsize) == 0));
+	right_move = +1 - (xsize * ((pos%xsize) == (xsize-1)));
+	val = my_grid[pos]; // Value of the grid in pos
+	nei = val>>2; // The number of neighbour is stored starting from the third bit on the char
+	prev = val & 2; // The value of the previous cell is stored in the second bit. This is prev*2
+	// The first element is the first cell of the row or a l_ind point: the change of the cell on its left
+	// (if any) doesn't change its new state, so it's evolved with the value it has now
+	my_current = val & 1;
+	my_new = RULE_NEW_STATE(my_current, nei); 
+	my_grid[pos] = (nei*4) + prev + my_new; // Updating the cell
+	diff = my_new - my_current;
+	// Updating the value of prev in the next cell
+	my_grid[pos + 1] += diff*2;					
+	// Updating the value of nei in the near cells
+	diff *= 4;
+	my_grid[pos + up_move + left_move]    += diff;  // diff now stores 4*(my_new - my_current)
+	my_grid[pos + up_move]                += diff;
+	my_grid[pos + up_move + right_move]   += diff;
+	my_grid[pos + left_move]              += diff * first;	// We pass backward this information only if this is the first
+								// element of the row. Sending the this information backward 
+								// would create some irregularities, so the right way is to 
+								// modify the last element of each fragment at the end of the fragments
+	my_grid[pos + right_move]             += diff;
+	my_grid[pos + down_move + left_move]  += diff;
+	my_grid[pos + down_move]              += diff;
+	my_grid[pos + down_move + right_move] += diff;
+	
+	// Working on the other elements of the fragment
+	// A cell that doesn't change state keeps its value, so only the cells that can change are evolved:
+	// the cells that would change with their value (found with a vector scan, 64 cells at a time)
+	// and the cell after each one that changed (the only cell of the row whose value is changed
+	// before it's evolved). The cells are still evolved from left to right.
+	
+	changed = (diff != 0);  // the first element changed, the following one must be evolved
+	for(int block = pos + 1; block < end; block += 64){
+		block_size = (end - block < 64) ? end - block : 64;
+		todo = ordered_flip_mask(&my_grid[block], block_size) | (uint64_t)changed;
+		changed = 0;
+		while (todo != 0){
+			pos = block + __builtin_ctzll(todo);
+			todo &= todo - 1;
+			left_move = -1 + (xsize * ((pos%xsize) == 0));
+			right_move = +1 - (xsize * ((pos%xsize) == (xsize-1)));
+			val = my_grid[pos];
+			my_current = val & 1;
+			nei = val>>2;
+			prev = val & 2; // This is prev * 2
+			my_new = RULE_NEW_STATE(my_current, nei); 
+			if (my_new == my_current)
+				continue;
+			my_grid[pos] = (nei*4) + prev + my_new; // Updating the cell
+			diff = my_new - my_current;
+			// Updating the value of prev in the next cell
+			my_grid[pos + 1] += diff*2;					
+			// Updating the value of nei in the near cells
+			diff *=4;
+			my_grid[pos + up_move + left_move]    += diff;
+			my_grid[pos + up_move]                += diff;
+			my_grid[pos + up_move + right_move]   += diff;
+			my_grid[pos + left_move]              += diff;
+			my_grid[pos + right_move]             += diff;
+			my_grid[pos + down_move + left_move]  += diff;
+			my_grid[pos + down_move]              += diff;
+			my_grid[pos + down_move + right_move] += diff;
+			// The following cell must be evolved (in this block or at the beginning of the next one)
+			if (pos + 1 - block < block_size)
+				todo |= (uint64_t)1 << (pos + 1 - block);
+			else
+				changed = 1;
+		}
+	}// End of work on the fragment	
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void ordered_fix_fragments(unsigned char *my_grid, int y, int xsize, int count, int *l_ind_pos, int *l_ind_dist){
+
+	// Modifying the value of nei in the last element of each fragment of the row y (after all its fragments)
+
+	char nei;
+	int left_move, right_move;
+	int up_move = -xsize;
+	int down_move = xsize;
+	int pos;
+
+	for (int i = 0; i<count; i++){
+		pos = y*xsize + l_ind_pos[i] + l_ind_dist[i] - 1;
+		left_move = -1 + (xsize * ((pos%xsize) == 0));
+		right_move = +1 - (xsize * ((pos%xsize) == xsize-1));
+		nei = 0;
+		nei+=my_grid[pos + up_move + left_move] & 1;
+		nei+=my_grid[pos + up_move] & 1;
+		nei+=my_grid[pos + up_move + right_move] & 1;
+		nei+=my_grid[pos + left_move] & 1;
+		nei+=my_grid[pos + right_move] & 1;
+		nei+=my_grid[pos + down_move + left_move] & 1;
+		nei+=my_grid[pos + down_move] & 1;
+		nei+=my_grid[pos + down_move + right_move] & 1;
+		my_grid[pos] = (nei*4) + (my_grid[pos] & 3); // The first two bits stay the same
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void ordered_last_row(unsigned char *my_grid, unsigned char *bottom_ghost_row, int xsize, int my_chunk){
+
+	// Updating the last line (no parallelization). The neighbours below are read from the bottom ghost row
+
+	char prev, nei, diff;
+	char my_current, my_new;
+	int left_move, right_move;
+	int up_move = -xsize;      // This will make it go up a row
+	int pos;
+	int y = my_chunk - 1;
+
+	for (int x = 0; x < xsize; x++){
+		
+		pos = y*xsize + x;   // Current position
+		nei = 0;
+		left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
+		right_move = +1 - (xsize * (x == (xsize-1))); //This will make it go down a row if on the right border
+		// Computing the number of neighbours
+		nei+=my_grid[pos + up_move + left_move] & 1;
+		nei+=my_grid[pos + up_move] & 1;
+		nei+=my_grid[pos + up_move + right_move] & 1;
+		nei+=my_grid[pos + left_move] & 1;
+		nei+=my_grid[pos + right_move] & 1;
+		nei+=bottom_ghost_row[x + left_move] & 1;
+		nei+=bottom_ghost_row[x] & 1;
+		nei+=bottom_ghost_row[x + right_move] & 1;
+		// Computing prev 
+		prev = my_grid[pos -1] & 1;
+		// Evolving the state
+		my_current = my_grid[pos] & 1;
+		my_new = RULE_NEW_STATE(my_current, nei);
+		diff = my_new - my_current;
+		my_grid[pos] = (nei*4) + (prev*2) + my_new;
+		// Updating the value nei in the other cells
+		my_grid[pos + left_move]            += diff*4;
+		my_grid[pos + up_move + left_move]  += diff*4; 
+		my_grid[pos + up_move]              += diff*4;
+		my_grid[pos + up_move + right_move] += diff*4;
+		if (x == xsize-1){
+			my_grid[pos + right_move]   += diff*4;
+		}
+		
+	}// end of work on the last line
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
 int sanity_check_ordered(unsigned char *my_grid, int xsize, int my_chunk, unsigned char *top_ghost_row, unsigned char *bottom_ghost_row){
 
         // checks if the grid is correctly evaluated
@@ -448,20 +655,8 @@ void ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cel
 		
 	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
 
-	char val;
-	char diff;
-	char prev; // Will be 1 if the previous cell is alive and 0 otherwise
-	char nei; // Number of alive neighbours
-	char my_current, my_new; // current/new state of the cell. It can be either 1 or 0
 	int y;
 	int stride = 640;  // The minimum size of the fragment of the row in which a thread will work
-
-	//This will help in the computation of neighbuouring cells
-	int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
-	int right_move;   // right_move = +1 - (xsize if x == xsize-1). This will make it go down a row if on the right border
-	int up_move = -xsize;      // This will make it go up a row (There's no way of looping back to the top row because we use ghost rows)
-	int down_move = xsize;     // This will make it go down a row
-	int pos;          // pos = y*xsize + x.   Current position
 	
 	int rank, size;
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
@@ -494,46 +689,7 @@ void ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cel
         MPI_Waitall(2, initial, MPI_STATUSES_IGNORE);
 
 	// Initializing the grid to get the right value of prev and nei for all cells 
-	
-	for (int y = 0; y<my_chunk; y++){
-		for (int x = 0; x<xsize; x++){
-		
-			pos = y*xsize + x;   //Current position
-			nei = 0;
-			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
-			right_move = +1 - (xsize * (x == xsize-1)); //This will make it go down a row if on the right border
-			
-			//computing the number of neighbours
-			if (y==0){  // Using the top_ghost_row
-				nei+=top_ghost_row[x + left_move] & 1; //  & 1 will give the value of the first bit
-				nei+=top_ghost_row[x] & 1;
-				nei+=top_ghost_row[x + right_move] & 1;
-			}else{
-				nei+=my_grid[pos - xsize + left_move] & 1;
-				nei+=my_grid[pos - xsize] & 1;
-				nei+=my_grid[pos - xsize + right_move] & 1;
-			}
-			nei+=my_grid[pos + left_move] & 1;
-			nei+=my_grid[pos + right_move] & 1;
-			if (y==my_chunk-1){  // Using the bottom_ghost_row
-				nei+=bottom_ghost_row[x + left_move] & 1;
-				nei+=bottom_ghost_row[x] & 1;
-				nei+=bottom_ghost_row[x + right_move] & 1;
-			}else{
-				nei+=my_grid[pos + xsize + left_move] & 1;
-				nei+=my_grid[pos + xsize] & 1;
-				nei+=my_grid[pos + xsize + right_move] & 1;
-			}
-			//computing prev
-			if (pos!=0){
-				prev = my_grid[pos -1] & 1;
-			}else{
-				prev = 0;
-			}
-			// the value of each cell will encode its state, the previous cell state and the live neighbours
-			my_grid[pos] = (nei*4) + (prev*2) + (my_grid[pos] & 1);
-		}	
-	} // The grid is initialized with the right encoding
+	ordered_encode(my_grid, xsize, my_chunk, top_ghost_row, bottom_ghost_row);
 	
 	// Sending the bottom row of the last MPI process to begin the gen cycle. The tag is 0
 	if (rank == size-1){
@@ -562,45 +718,7 @@ void ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cel
 		// Updating the first line (no parallelization)
 		
 		y = 0;
-		for (int x = 0; x < xsize; x++){
-			
-			pos = x;   //Current position
-			nei = 0;
-			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
-			right_move = +1 - (xsize * (x == (xsize-1))); //This will make it go down a row if on the right border
-			// computing the number of neighbours
-			nei+=top_ghost_row[x + left_move] & 1;
-			nei+=top_ghost_row[x] & 1;
-			nei+=top_ghost_row[x + right_move] & 1;
-			nei+=my_grid[pos + left_move] & 1;
-			nei+=my_grid[pos + right_move] & 1;
-			nei+=my_grid[pos + down_move + left_move] & 1;
-			nei+=my_grid[pos + down_move] & 1;
-			nei+=my_grid[pos + down_move + right_move] & 1;
-			// computing prev 
-			if (pos!=0){
-				prev = my_grid[pos -1] & 1;
-			}else{
-				prev = 0;
-			}
-			// Evolving the state
-			my_current = my_grid[pos] & 1;
-			my_new = (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3)); // Evaluates the new state of the grid
-			diff = my_new - my_current;
-			my_grid[pos] = (nei*4) + (prev*2) + my_new;
-			// Updating the value of prev in the next cell 
-			my_grid[pos + 1] += diff*2; // The value of the second bit will increase or decrease by one
-			// Updating the value nei in the other cells
-			my_grid[pos + left_move]              += diff*4;
-			my_grid[pos + down_move + left_move]  += diff*4; // nei is stored starting from the third bit, it will 
-			my_grid[pos + down_move]              += diff*4; // increase or decrease by one
-			my_grid[pos + down_move + right_move] += diff*4;
-			if (x == xsize-1){
-                                my_grid[pos + right_move]     += diff*4;
-                        }
-
-
-		}// end of work on the first line
+		ordered_first_row(my_grid, top_ghost_row, xsize);
 		
 		// Sending the fist line. The tag is 1
 		MPI_Request sendfirst;
@@ -612,90 +730,13 @@ void ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cel
 		// Updating the central lines ( PARALLELIZATION ) 
 		
 		for (int y = 1; y < my_chunk-1; y++){
-			#pragma omp parallel for schedule( static, 1 ) private(pos, nei, left_move, right_move, prev, my_current, my_new, val, diff)
+			#pragma omp parallel for schedule( static, 1 )
 			for (int i = 0; i<count; i++){
-				// Updating the first element
-				
-				pos = y*xsize + l_ind_pos[i];
-				left_move = -1 + (xsize * ((pos%xsize) == 0));
-				right_move = +1 - (xsize * ((pos%xsize) == (xsize-1)));
-				val = my_grid[pos]; // Value of the grid in pos
-				nei = val>>2; // The number of neighbour is stored starting from the third bit on the char
-				prev = val & 2; // The value of the previous cell is stored in the second bit. This is prev*2
-				if (i != 0){
-					// Here the first element is a l_ind point
-					my_current = val & 1;
-					// if the first element is a l_ind point, it will become 1 only if its value is either 9 or 15 (see image)
-					my_new = ((val==9) || (val==15)) ? 1 : 0; 
-				}else{
-					// Here the first element is the first cell of the row
-					my_current = val & 1;
-					my_new = (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3)); 
-				}
-				my_grid[pos] = (nei*4) + prev + my_new; // Updating the cell
-				diff = my_new - my_current;
-				// Updating the value of prev in the next cell
-				my_grid[pos + 1] += diff*2;					
-				// Updating the value of nei in the near cells
-				diff *= 4;
-				my_grid[pos + up_move + left_move]    += diff;  // diff now stores 4*(my_new - my_current)
-				my_grid[pos + up_move]                += diff;
-				my_grid[pos + up_move + right_move]   += diff;
-				my_grid[pos + left_move]              += diff * (i==0);		// We pass backward this information only if this is the first
-												// element of the row. Sending the this information backward 
-												// would create some irregularities, so the right way is to 
-												// modify the last element of each fragment at the end of the fragments
-				my_grid[pos + right_move]             += diff;
-				my_grid[pos + down_move + left_move]  += diff;
-				my_grid[pos + down_move]              += diff;
-				my_grid[pos + down_move + right_move] += diff;
-				
-				// Working on the other elements of the fragment
-				
-				for(int j = 1; j<l_ind_dist[i]; j++){
-					pos++;
-					nei = 0;
-					left_move = -1 + (xsize * ((pos%xsize) == 0));
-					right_move = +1 - (xsize * ((pos%xsize) == (xsize-1)));
-					val = my_grid[pos];
-					my_current = val & 1;
-					nei = val>>2;
-					prev = val & 2; // This is prev * 2
-					my_new = (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3)); 
-					my_grid[pos] = (nei*4) + prev + my_new; // Updating the cell
-					diff = my_new - my_current;
-					// Updating the value of prev in the next cell
-					my_grid[pos + 1] += diff*2;					
-					// Updating the value of nei in the near cells
-					diff *=4;
-					my_grid[pos + up_move + left_move]    += diff;
-					my_grid[pos + up_move]                += diff;
-					my_grid[pos + up_move + right_move]   += diff;
-					my_grid[pos + left_move]              += diff;
-					my_grid[pos + right_move]             += diff;
-					my_grid[pos + down_move + left_move]  += diff;
-					my_grid[pos + down_move]              += diff;
-					my_grid[pos + down_move + right_move] += diff;
-				}// End of work on the fragment	
+				ordered_fragment(my_grid, y, xsize, l_ind_pos[i], l_ind_dist[i], i == 0);
 			}// End of the omp parallel
 			
 			// Modifying the value of nei in the last element of each fragment
-			
-			for (int i = 0; i<count; i++){
-				pos = y*xsize + l_ind_pos[i] + l_ind_dist[i] - 1;
-				left_move = -1 + (xsize * ((pos%xsize) == 0));
-				right_move = +1 - (xsize * ((pos%xsize) == xsize-1));
-				nei = 0;
-				nei+=my_grid[pos + up_move + left_move] & 1;
-				nei+=my_grid[pos + up_move] & 1;
-				nei+=my_grid[pos + up_move + right_move] & 1;
-				nei+=my_grid[pos + left_move] & 1;
-				nei+=my_grid[pos + right_move] & 1;
-				nei+=my_grid[pos + down_move + left_move] & 1;
-				nei+=my_grid[pos + down_move] & 1;
-				nei+=my_grid[pos + down_move + right_move] & 1;
-				my_grid[pos] = (nei*4) + (my_grid[pos] & 3); // The first two bits stay the same
-			}
+			ordered_fix_fragments(my_grid, y, xsize, count, l_ind_pos, l_ind_dist);
 			
 			// Creating the next arrays of the line_independent points
 			count =	l_ind(my_grid, y, xsize, stride, l_ind_pos, l_ind_dist);
@@ -710,40 +751,7 @@ void ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cel
         	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
 		
 		// Updating the last line (no parallelization)
-		
-		y = my_chunk - 1;
-		for (int x = 0; x < xsize; x++){
-			
-			pos = y*xsize + x;   // Current position
-			nei = 0;
-			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
-			right_move = +1 - (xsize * (x == (xsize-1))); //This will make it go down a row if on the right border
-			// Computing the number of neighbours
-			nei+=my_grid[pos + up_move + left_move] & 1;
-			nei+=my_grid[pos + up_move] & 1;
-			nei+=my_grid[pos + up_move + right_move] & 1;
-			nei+=my_grid[pos + left_move] & 1;
-			nei+=my_grid[pos + right_move] & 1;
-			nei+=bottom_ghost_row[x + left_move] & 1;
-			nei+=bottom_ghost_row[x] & 1;
-			nei+=bottom_ghost_row[x + right_move] & 1;
-			// Computing prev 
-			prev = my_grid[pos -1] & 1;
-			// Evolving the state
-			my_current = my_grid[pos] & 1;
-			my_new = (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3));
-			diff = my_new - my_current;
-			my_grid[pos] = (nei*4) + (prev*2) + my_new;
-			// Updating the value nei in the other cells
-			my_grid[pos + left_move]            += diff*4;
-			my_grid[pos + up_move + left_move]  += diff*4; 
-			my_grid[pos + up_move]              += diff*4;
-			my_grid[pos + up_move + right_move] += diff*4;
-			if (x == xsize-1){
-				my_grid[pos + right_move]   += diff*4;
-			}
-			
-		}// end of work on the last line
+		ordered_last_row(my_grid, bottom_ghost_row, xsize, my_chunk);
 		
 		// Checking if the grid is correct
 		//errors = sanity_check_ordered(my_grid, xsize, my_chunk, top_ghost_row, bottom_ghost_row);
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include <omp.h>
+
+void interior_first_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution where the central rows are evolved while both ghost rows are still travelling.
+	// With the encoding of static_evolution (the state alternates between bit 1 and bit 2) a row can be evolved
+	// before the rows around it, since the evolution preserves the bit of the current state.
+	// So the rows from 1 to my_chunk-2 don't need the ghost rows, and only the first and the last row
+	// wait for the communications, at the end of the generation.
+	//
+	// MPI communications stucture:
+	//
+	// 	Central rows (the master thread checks if the ghost rows arrived after each of its rows)
+	// Wait(sendfirst, recvtop)
+	// 	First row
+	// Wait(sendlast, recvbottom)
+	//	Last row
+	// isend/irecv(sendfirst, recvtop, sendlast, recvbottom)
+	// Writing snapshots
+	//
+	// To measure how much of the halo latency is hidden, the time between the irecv and the arrival of the
+	// ghost row (latency) is compared with the time spent waiting for it in MPI_Wait (exposed latency).
+
+	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	// Alternating positions of the current and next states of the system
+	char current = 1;
+	char next = 2;
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Times for the measure of the hidden latency
+	double t_posted;                        // time of the irecv of the ghost rows
+	double t_arrived_top, t_arrived_bottom; // time of arrival of the ghost rows (-1 if they didn't arrive yet)
+	double t_wait;                          // beginning of MPI_Wait
+	double latency = 0;                     // sum of the latencies of the ghost rows
+	double exposed = 0;                     // sum of the times spent waiting for the ghost rows
+	int flag;
+
+	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
+
+	// Sharing the ghost rows to start the generations
+
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0,MPI_COMM_WORLD, &recvtop);
+	t_posted = MPI_Wtime();
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// Alternating positions of the current and next states of the system
+		current = gen % 2 + 1;
+		next = 2 - gen % 2;
+
+		t_arrived_top = -1;
+		t_arrived_bottom = -1;
+
+		// Parallel evolution of the central rows, while the ghost rows are arriving
+		#pragma omp parallel for schedule( static ) private(flag)
+		for(int y=1; y<my_chunk-1; y++){
+			static_evolve_row(&my_grid[(y-1)*xsize], &my_grid[y*xsize], &my_grid[(y+1)*xsize], xsize, current, next);
+
+			// The master thread checks the ghost rows (this also lets MPI progress with the communications)
+			if (omp_get_thread_num() == 0){
+				if (t_arrived_top < 0){
+					MPI_Test(&recvtop, &flag, MPI_STATUS_IGNORE);
+					if (flag)
+						t_arrived_top = MPI_Wtime();
+				}
+				if (t_arrived_bottom < 0){
+					MPI_Test(&recvbottom, &flag, MPI_STATUS_IGNORE);
+					if (flag)
+						t_arrived_bottom = MPI_Wtime();
+				}
+			}
+		}// end omp parallel
+
+		// Waiting for the operations on the first row
+		t_wait = MPI_Wtime();
+		MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+		if (t_arrived_top < 0)
+			t_arrived_top = MPI_Wtime();
+		exposed += t_arrived_top - ((t_arrived_top > t_wait) ? t_wait : t_arrived_top);
+		latency += t_arrived_top - t_posted;
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+
+		// Evolution of the first row (if the process has a single row, also the bottom ghost row is needed)
+		if (my_chunk == 1){
+			MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		}
+		static_evolve_row(top_ghost_row, &my_grid[0], (my_chunk == 1) ? bottom_ghost_row : &my_grid[xsize], xsize, current, next);
+
+		// Waiting for the operations on the last row
+		t_wait = MPI_Wtime();
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		if (t_arrived_bottom < 0)
+			t_arrived_bottom = MPI_Wtime();
+		exposed += t_arrived_bottom - ((t_arrived_bottom > t_wait) ? t_wait : t_arrived_bottom);
+		latency += t_arrived_bottom - t_posted;
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+		// Evolution of the last row
+		if (my_chunk > 1){
+			static_evolve_row(&my_grid[(my_chunk - 2) * xsize], &my_grid[(my_chunk - 1) * xsize], bottom_ghost_row, xsize, current, next);
+		}
+
+		// Sending the fist line. The tag is 1
+		MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+		// Sending the last row. The tag is 0
+		MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+		// Receving the new top_ghost_row. The tag is 0
+		MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+		// Receving the new bottom_ghost_row. The tag is 1
+		MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+		t_posted = MPI_Wtime();
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			//writing the temporary grid
+			for (int i=0; i<xsize*my_chunk; i++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[i] = ((my_grid[i] & current) == current);
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+	} // End cycle on gen
+
+	// Deallocating all the handles
+	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+	// Reporting the hidden latency (summed over all processes). It's printed on stderr to keep the timing output clean
+	double local_times[2] = {latency, exposed};
+	double total_times[2];
+	MPI_Reduce(local_times, total_times, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0 && total_times[0] > 0){
+		fprintf(stderr, "Halo latency: %f s, exposed: %f s, hidden: %.1f%%\n", total_times[0], total_times[1], 100.0 * (1.0 - total_times[1] / total_times[0]));
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	if (top_ghost_row != NULL)
+		free(top_ghost_row);
+	if (bottom_ghost_row != NULL)
+		free(bottom_ghost_row);
+
+	// Writing the snapshot file (like in static_evolution)
+	if(s == n){
+		//writing the temporary grid
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = ((my_grid[i] & current) == current);
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	return;
+}
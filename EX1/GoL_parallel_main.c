@@ -11,6 +11,24 @@
 #include <math.h>
 #include "GoL_parallel_init_evol.h"
 #include "GoL_parallel_read_write.h"
+#include "GoL_parallel_packed.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_deep_halo.h"
+#include "GoL_parallel_persistent.h"
+#include "GoL_parallel_interior_first.h"
+#include "GoL_parallel_tiles.h"
+#include "GoL_parallel_hashlife.h"
+#include "GoL_parallel_alloc.h"
+#include "GoL_parallel_streaming.h"
+#include "GoL_parallel_temporal.h"
+#include "GoL_parallel_dataflow.h"
+#include "GoL_parallel_speculative.h"
+#include "GoL_parallel_ensemble.h"
+#include "GoL_parallel_cart.h"
+#include "GoL_parallel_shm.h"
+#include "GoL_parallel_halo.h"
+#include "GoL_parallel_partitioned.h"
+#include "GoL_parallel_balance.h"
 
 
 struct timeval start_time, end_time;
@@ -19,6 +37,22 @@ struct timeval start_time, end_time;
 
 #define ORDERED 0
 #define STATIC 1
+#define HASHLIFE 2
+#define PACKED 3
+#define PACKED_ORDERED 4
+
+// Execution modes of the static evolution
+#define MODE_DEFAULT 0
+#define MODE_PERSISTENT 1
+#define MODE_INTERIOR_FIRST 2
+#define MODE_STREAMING 3
+#define MODE_TEMPORAL 4
+#define MODE_DATAFLOW 5
+#define MODE_SPECULATIVE 6
+#define MODE_CART 7
+#define MODE_SHARED 8
+#define MODE_PARTITIONED 9
+#define MODE_BALANCED 10
 
 int main ( int argc, char **argv ) {
 	/*Each character in the optstring represents a single-character
@@ -27,19 +61,55 @@ int main ( int argc, char **argv ) {
 	-i: No argument required. Initialize playground.
 	-r: No argument required. Run a playground.
 	-k: Requires an argument (e.g., -k 100). Playground size.
-	-e: Requires an argument (e.g., -e 1). Evolution type.
+	-e: Requires an argument (e.g., -e 1). Evolution type (0 ordered, 1 static, 2 hashlife,
+	3 static on a bit-packed grid, 4 ordered on a bit-packed grid). The hashlife evolution runs only on the process 0.
 	-f: Requires an argument (e.g., -f filename.pgm). 
 	Name of the file to be either read or written
 	-n: Requires an argument (e.g., -n 10000). Number of steps.
-	-s: Requires an argument (e.g., -s 1). Frequency of dump.*/
+	-s: Requires an argument (e.g., -s 1). Frequency of dump.
+	-v: Requires an argument (e.g., -v avx2). Forces the version of the vectorized kernels
+	(scalar, lut, sse2, avx2, avx512). By default the best one supported by the cpu is used.
+	-H: Requires an argument (e.g., -H 4). Depth of the halo in the static evolution: the ghost
+	rows are exchanged every H generations (default 1). With -m 4 it's the number of generations
+	of each wave of tiles (default TEMPORAL_DEPTH).
+	-m: Requires an argument (e.g., -m 1). Execution mode of the static evolution
+	(0 default, 1 persistent omp team, 2 interior rows first, overlapped with the halo exchange,
+	3 double-buffered with non-temporal stores, 4 temporal tiling: bands of rows advanced by H generations in L2,
+	5 omp tasks with dependencies between the bands of rows, without barriers between the generations,
+	7 2D decomposition of the board in blocks on a cartesian grid of processes,
+	8 ghost rows read from the shared memory of the processes on the same node,
+	9 first and last rows sent in slices, each one as soon as its omp thread has evolved it,
+	10 rows moved between neighbouring processes every b generations to even out their compute times).
+	With -e 0, -m 1 runs the ordered evolution with a persistent omp team (no fork/join for each row),
+	-m 6 splits each row in equal fragments evolved speculatively in parallel (the wrong ones are evolved again).
+	-t: Requires an argument (e.g., -t 64). Size of the tiles for skipping the quiescent regions
+	in the ordered and static evolution (default 0, no skipping).
+	-R: Requires an argument (e.g., -R B36/S23). Rule of the evolution, with the numbers of neighbours
+	that make a cell born (B) or survive (S) (default B3/S23).
+	-E: Requires an argument (e.g., -E 8). Number of boards of the ordered evolution (default 1): with more
+	boards (the input board and copies of it with ENSEMBLE_PERTURBATION of the cells flipped at random, different for
+	each board) they are evolved staggered around the ring of the processes.
+	-x: Requires an argument (e.g., -x persistent). Backend of the exchange of the ghost rows in the default and in the
+	double-buffered static evolution (-m 0 and -m 3): p2p (default), persistent, neighbor, rma. Its time per generation
+	is reported. The other modes have their own exchange and don't use it.
+	-b: Requires an argument (e.g., -b 20). Every how many generations the rows are balanced between the
+	processes in the static evolution with -m 10 (default BALANCE_PERIOD).*/
 	int   action = 0;
 	int   k      = 100;  //size of the squared  playground
-	int   e      = 0; //evolution type [0\1]
+	int   e      = 0; //evolution type [0\1\2\3\4]
 	int   n      = 100;  // number of iterations 
 	int   s      = 1;      // every how many steps a dump of the system is saved on a file
 	// 0 meaning only at the end.
 	char *fname  = NULL;
-	char *optstring = "irk:e:f:n:s:";
+	char *isa    = NULL;  // version of the vectorized kernels (NULL means the best one)
+	int   h      = 1;     // depth of the halo (number of ghost rows) in the static evolution
+	int   m      = MODE_DEFAULT;  // execution mode of the static evolution
+	int   t      = 0;     // size of the tiles for skipping the quiescent regions (0 means no skipping)
+	char *rule   = NULL;  // rule of the evolution (NULL means B3/S23)
+	int   ens    = 1;     // number of boards of the ordered ensemble
+	char *halo   = NULL;  // backend of the exchange of the ghost rows (NULL means p2p)
+	int   b      = 0;     // period of the row balancing (0 means BALANCE_PERIOD)
+	char *optstring = "irk:e:f:n:s:v:H:m:t:R:E:x:b:";
 
 	int c;
 	/*When the getopt function is called in the while loop,
@@ -62,7 +132,7 @@ int main ( int argc, char **argv ) {
 				e = atoi(optarg); 
 				break;
 			case 'f':
-				fname = (char*)malloc( sizeof(optarg)+1 );
+				fname = (char*)malloc( strlen(optarg)+1 );
 				sprintf(fname, "%s", optarg );
 				break;  
 			case 'n':
@@ -71,6 +141,30 @@ int main ( int argc, char **argv ) {
 			case 's':
 				s = atoi(optarg); 
 				break;
+			case 'v':
+				isa = optarg;
+				break;
+			case 'H':
+				h = atoi(optarg);
+				break;
+			case 'm':
+				m = atoi(optarg);
+				break;
+			case 't':
+				t = atoi(optarg);
+				break;
+			case 'R':
+				rule = optarg;
+				break;
+			case 'E':
+				ens = atoi(optarg);
+				break;
+			case 'x':
+				halo = optarg;
+				break;
+			case 'b':
+				b = atoi(optarg);
+				break;
 			default :
 				printf("argument -%c not known\n", c ); 
 				break;
@@ -93,14 +187,32 @@ int main ( int argc, char **argv ) {
 		double mean_time;
 		double time_elapsed;
 		
-		// Initializing MPI
-		MPI_Init(NULL, NULL);
+		// Initializing MPI. Only one omp thread at a time will make MPI calls (the master thread,
+		// or any thread in the tasks of the dataflow mode)
+		int provided;
+		MPI_Init_thread(NULL, NULL, MPI_THREAD_SERIALIZED, &provided);
 		int my_rank;
 		int size;
 		
 		// Getting the rank and the size
 		MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
 		MPI_Comm_size(MPI_COMM_WORLD, &size);
+		
+		// Setting the rule of the evolution
+		if (rule != NULL && set_rule(rule) != 0 && my_rank == 0){
+			fprintf(stderr, "Rule %s not valid, using B3/S23\n", rule);
+		}
+		// Choosing the version of the kernels for the cpu of this node
+		if (select_static_kernel(isa) != 0 && my_rank == 0){
+			fprintf(stderr, "Kernel version %s not available, using %s\n", isa, static_kernel_name());
+		}
+		// Choosing the backend of the halo exchange
+		if (select_halo_backend(halo) != 0 && my_rank == 0){
+			fprintf(stderr, "Halo backend %s not known, using %s\n", halo, halo_backend_name());
+		}
+		if (halo != NULL && (e != STATIC || t > 0 || h > 1 || (m != MODE_DEFAULT && m != MODE_STREAMING)) && my_rank == 0){
+			fprintf(stderr, "Halo backend %s is used only by the static evolution with -m 0 and -m 3\n", halo);
+		}
 		// Checking the number of processes and threads
 		//if (my_rank == 0){
 		//	printf("MPI initialized with %d processes\n", size);
@@ -111,10 +223,14 @@ int main ( int argc, char **argv ) {
 		int chunk = k / size;
 		int mod = k % size;
 		int my_chunk = chunk + (my_rank < mod); // Number of rows for the MPI process
-		int my_n_cells = my_chunk * k;  // Number fo cells for the MPI process
 		
 		unsigned char *grid = (unsigned char *)malloc(n_cells * sizeof(unsigned char));
-		unsigned char *my_grid = (unsigned char *)malloc(my_n_cells * sizeof(unsigned char));
+		// The rows of the process are placed on the NUMA nodes of the omp threads that work on them
+		unsigned char *my_grid = grid_alloc(my_chunk, k * sizeof(unsigned char));
+		if (my_grid == NULL){
+			fprintf(stderr, "Process %d: can't allocate its %d rows of the playground\n", my_rank, my_chunk);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
 		
 		// Reading the initial pgm file
 		if (my_rank == 0){
@@ -132,18 +248,127 @@ int main ( int argc, char **argv ) {
 		
 		// Scattering the grid across the processes
 		MPI_Scatterv(grid, num_cells, displs, MPI_UNSIGNED_CHAR, my_grid, num_cells[my_rank], MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		grid_placement_report(my_grid, "Grid memory");
 		
 		MPI_Barrier(MPI_COMM_WORLD);
 
 		// Starting the evolution
 		gettimeofday(&start_time, NULL);
-		if(e == ORDERED){
+		if(e == ORDERED && ens > 1){
+
+			if(s>0){
+				ensemble_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s, ens);
+			}else if (s==0){
+				ensemble_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n, ens);
+			}
+		}else if(e == ORDERED && t > 0){
+
+			if(s>0){
+				tile_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s, t);
+			}else if (s==0){
+				tile_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n, t);
+			}
+		}else if(e == ORDERED && m == MODE_PERSISTENT){
+
+			if(s>0){
+				persistent_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				persistent_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == ORDERED && m == MODE_SPECULATIVE){
+
+			if(s>0){
+				speculative_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				speculative_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == ORDERED){
 
 			if(s>0){
 				ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
 			}else if (s==0){
 				ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
 			}
+		}else if(e == STATIC && t > 0){
+
+			if(s>0){
+				tile_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s, t);
+			}else if (s==0){
+				tile_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n, t);
+			}
+		}else if(e == STATIC && m == MODE_TEMPORAL){
+
+			int depth = (h > 1) ? h : TEMPORAL_DEPTH;
+			if(s>0){
+				temporal_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s, depth);
+			}else if (s==0){
+				temporal_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n, depth);
+			}
+		}else if(e == STATIC && h > 1){
+
+			if(s>0){
+				deep_halo_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s, h);
+			}else if (s==0){
+				deep_halo_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n, h);
+			}
+		}else if(e == STATIC && m == MODE_PERSISTENT){
+
+			if(s>0){
+				persistent_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				persistent_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == STATIC && m == MODE_INTERIOR_FIRST){
+
+			if(s>0){
+				interior_first_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				interior_first_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == STATIC && m == MODE_DATAFLOW){
+
+			if(s>0){
+				dataflow_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				dataflow_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == STATIC && m == MODE_CART){
+
+			if(s>0){
+				cart_static_evolution(grid, k, n, s);
+			}else if (s==0){
+				cart_static_evolution(grid, k, n, n);
+			}
+		}else if(e == STATIC && m == MODE_SHARED){
+
+			if(s>0){
+				shm_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				shm_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == STATIC && m == MODE_PARTITIONED){
+
+			if(s>0){
+				partitioned_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				partitioned_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == STATIC && m == MODE_BALANCED){
+
+			// The rows of the process can change: my_grid and my_chunk are updated
+			int period = (b > 0) ? b : BALANCE_PERIOD;
+			if(s>0){
+				balanced_static_evolution(&my_grid, grid, num_cells, displs, k, &my_chunk, n, s, period);
+			}else if (s==0){
+				balanced_static_evolution(&my_grid, grid, num_cells, displs, k, &my_chunk, n, n, period);
+			}
+		}else if(e == STATIC && m == MODE_STREAMING){
+
+			if(s>0){
+				streaming_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				streaming_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
 		}else if(e == STATIC){
 		
 			if(s>0){
@@ -151,6 +376,27 @@ int main ( int argc, char **argv ) {
 			}else if (s==0){
 				static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
 			}
+		}else if(e == HASHLIFE){
+
+			if(s>0){
+				hashlife_evolution(grid, k, n, s);
+			}else if (s==0){
+				hashlife_evolution(grid, k, n, n);
+			}
+		}else if(e == PACKED){
+
+			if(s>0){
+				packed_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				packed_static_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
+		}else if(e == PACKED_ORDERED){
+
+			if(s>0){
+				packed_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, s);
+			}else if (s==0){
+				packed_ordered_evolution(my_grid, grid, num_cells, displs, k, my_chunk, n, n);
+			}
 		}
 
 		MPI_Finalize();
@@ -163,8 +409,7 @@ int main ( int argc, char **argv ) {
 		
 		if( grid != NULL)
 			free(grid);
-		if( my_grid != NULL)
-			free(my_grid);
+		grid_free(my_grid);
 		
 		if (my_rank == 0) {
 			printf("%f,", mean_time);
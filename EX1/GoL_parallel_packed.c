@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_parallel_packed.h"
+#include "GoL_kernels.h"
+#include <omp.h>
+
+void pack_row(unsigned char *row, uint64_t *packed_row, int xsize){
+
+	// Stores the row of chars (one cell per char) in a row of 64 bits words.
+	// The cell x is stored in the bit (x % 64) of the word (x / 64).
+	// The bits after the last cell of the row are always kept to zero.
+
+	int n_words = (xsize + 63) / 64;
+
+	for (int w=0; w<n_words; w++){
+		uint64_t word = 0;
+		int x_end = (64*(w+1) < xsize) ? 64*(w+1) : xsize;
+		for (int x=64*w; x<x_end; x++){
+			word |= (uint64_t)(row[x] & 1) << (x - 64*w);
+		}
+		packed_row[w] = word;
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void unpack_row(uint64_t *packed_row, unsigned char *row, int xsize){
+
+	// Inverse of pack_row. Each char of the row will be either 0 or 1
+
+	for (int x=0; x<xsize; x++){
+		row[x] = (packed_row[x / 64] >> (x % 64)) & 1;
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static inline __attribute__((always_inline)) uint64_t packed_rule(uint64_t up_left, uint64_t up, uint64_t up_right, uint64_t left, uint64_t my_current, uint64_t right, uint64_t down_left, uint64_t down, uint64_t down_right, unsigned int birth, unsigned int survive){
+
+	// Evolves 64 cells at the same time. Each argument contains, for every cell of the word, the
+	// state of one of its neighbours (or the state of the cell itself for my_current).
+	// The number of live neighbours is computed bit by bit with a tree of half and full adders,
+	// so that at the end nei = ones + 2*twos + 4*fours + 8*eights for each of the 64 cells.
+	// With B3/S23 the case nei = 8 can be treated as 0 (both kill the cell), so eights is not needed.
+	// The other rules (masks birth and survive) compare nei with each number of neighbours in the masks
+	// (with constant masks only the needed comparisons remain).
+
+	uint64_t s_up = up_left ^ up;                                               // half adder on the upper neighbours
+	uint64_t c_up = up_left & up;
+	uint64_t s_mid = up_right ^ left ^ right;                                   // full adder on three other neighbours
+	uint64_t c_mid = (up_right & left) | (right & (up_right ^ left));
+	uint64_t s_down = down_left ^ down ^ down_right;                            // full adder on the lower neighbours
+	uint64_t c_down = (down_left & down) | (down_right & (down_left ^ down));
+
+	uint64_t ones = s_up ^ s_mid ^ s_down;                                      // Adding the three partial sums
+	uint64_t carry_ones = (s_up & s_mid) | (s_down & (s_up ^ s_mid));
+	uint64_t twos_partial = c_up ^ c_mid ^ c_down;                              // Adding the three carries
+	uint64_t fours_partial = (c_up & c_mid) | (c_down & (c_up ^ c_mid));
+	uint64_t twos = twos_partial ^ carry_ones;
+	uint64_t fours = fours_partial ^ (twos_partial & carry_ones);
+
+	// The cell will be alive if nei == 3, or if nei == 2 and the cell is alive
+	if (birth == RULE_CONWAY_BIRTH && survive == RULE_CONWAY_SURVIVE)
+		return twos & ~fours & (ones | my_current);
+
+	uint64_t eights = fours_partial & twos_partial & carry_ones;
+	uint64_t born = 0, survives = 0, equal;
+	for (int nn=0; nn<=8; nn++){
+		equal = ((nn & 1) ? ones : ~ones) & ((nn & 2) ? twos : ~twos) & ((nn & 4) ? fours : ~fours) & ((nn & 8) ? eights : ~eights);
+		if ((birth >> nn) & 1)
+			born |= equal;
+		if ((survive >> nn) & 1)
+			survives |= equal;
+	}
+	return (born & ~my_current) | (survives & my_current);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static inline __attribute__((always_inline)) void packed_evolve_row_rule(uint64_t *up_row, uint64_t *my_row, uint64_t *down_row, uint64_t *new_row, int xsize, unsigned int birth, unsigned int survive){
+
+	// Computes the next state of my_row (given the rows above and below it) and writes it in new_row.
+	// The neighbours on the left and on the right are obtained by shifting the words by one bit
+	// and moving in the bit coming from the adjacent word. The first and the last cells of the row
+	// are neighbours (torus), so the bit that enters the first word comes from the last cell of the row
+	// and the bit that enters the last word comes from the first cell.
+
+	int n_words = (xsize + 63) / 64;
+	int last_bit = (xsize - 1) % 64;  // position of the last cell of the row in the last word
+	uint64_t last_mask = (last_bit == 63) ? ~(uint64_t)0 : (((uint64_t)1 << (last_bit + 1)) - 1);
+
+	uint64_t left_in_up, left_in_my, left_in_down;     // bits that enter from the left
+	uint64_t right_in_up, right_in_my, right_in_down;  // bits that enter from the right
+
+	for (int w=0; w<n_words; w++){
+
+		if (w == 0){  // Taking the last cell of the row
+			left_in_up = (up_row[n_words-1] >> last_bit) & 1;
+			left_in_my = (my_row[n_words-1] >> last_bit) & 1;
+			left_in_down = (down_row[n_words-1] >> last_bit) & 1;
+		}else{
+			left_in_up = up_row[w-1] >> 63;
+			left_in_my = my_row[w-1] >> 63;
+			left_in_down = down_row[w-1] >> 63;
+		}
+		if (w == n_words-1){  // Taking the first cell of the row
+			right_in_up = (up_row[0] & 1) << last_bit;
+			right_in_my = (my_row[0] & 1) << last_bit;
+			right_in_down = (down_row[0] & 1) << last_bit;
+		}else{
+			right_in_up = up_row[w+1] << 63;
+			right_in_my = my_row[w+1] << 63;
+			right_in_down = down_row[w+1] << 63;
+		}
+
+		new_row[w] = packed_rule((up_row[w] << 1) | left_in_up, up_row[w], (up_row[w] >> 1) | right_in_up,
+		                         (my_row[w] << 1) | left_in_my, my_row[w], (my_row[w] >> 1) | right_in_my,
+		                         (down_row[w] << 1) | left_in_down, down_row[w], (down_row[w] >> 1) | right_in_down, birth, survive);
+	}
+	// Cleaning the bits after the last cell
+	new_row[n_words-1] &= last_mask;
+}
+
+void packed_evolve_row(uint64_t *up_row, uint64_t *my_row, uint64_t *down_row, uint64_t *new_row, int xsize){
+
+	// Evolves the row with the rule in use. The common rules get their own version of the row (with constant masks)
+
+	if (rule_birth == RULE_CONWAY_BIRTH && rule_survive == RULE_CONWAY_SURVIVE)
+		packed_evolve_row_rule(up_row, my_row, down_row, new_row, xsize, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+	else if (rule_birth == RULE_HIGHLIFE_BIRTH && rule_survive == RULE_HIGHLIFE_SURVIVE)
+		packed_evolve_row_rule(up_row, my_row, down_row, new_row, xsize, RULE_HIGHLIFE_BIRTH, RULE_HIGHLIFE_SURVIVE);
+	else if (rule_birth == RULE_DAYNIGHT_BIRTH && rule_survive == RULE_DAYNIGHT_SURVIVE)
+		packed_evolve_row_rule(up_row, my_row, down_row, new_row, xsize, RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVE);
+	else
+		packed_evolve_row_rule(up_row, my_row, down_row, new_row, xsize, rule_birth, rule_survive);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void packed_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution on a bit-packed grid: each row is stored in (xsize+63)/64 words of 64 bits
+	// and each cell is a single bit, so the memory traffic is 8 times smaller than in static_evolution.
+	// The new states of 64 cells are computed at the same time by packed_rule.
+	// Two packed grids are used (current and next generation) and they are swapped at the end of each generation.
+	// Each packed grid has one ghost row on top and one on the bottom, so that the first and last rows
+	// can be evolved like the central ones. Also the ghost rows are packed (xsize/8 bytes).
+	//
+	// The MPI communications have the same structure used in static_evolution:
+	//
+	// Wait(sendfirst, recvtop)
+	// 	First row
+	// isend/irecv(sendfirst, recvtop)
+	// Wait(sendlast, recvbottom)
+	//	Last row
+	// isend/irecv(sendlast, recvbottom)
+	// 	Central rows
+	// Writing snapshots
+	//
+	// The ghost rows are received directly in the grid of the next generation.
+
+	int n_words = (xsize + 63) / 64;  // Number of words in a row
+
+	// Row y of the portion is stored starting from (y+1)*n_words. Row 0 and row my_chunk+1 are the ghost rows
+	uint64_t *current_grid = (uint64_t *)malloc((my_chunk + 2) * n_words * sizeof(uint64_t));
+	uint64_t *next_grid = (uint64_t *)malloc((my_chunk + 2) * n_words * sizeof(uint64_t));
+	uint64_t *tmp_grid;
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Packing the portion of the grid
+	#pragma omp parallel for schedule( static )
+	for (int y=0; y<my_chunk; y++){
+		pack_row(&my_grid[y*xsize], &current_grid[(y+1)*n_words], xsize);
+	}
+
+	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
+
+	// Sharing the ghost rows to start the generations
+
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&current_grid[n_words], n_words, MPI_UINT64_T, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&current_grid[my_chunk*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Irecv(&current_grid[(my_chunk+1)*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Irecv(&current_grid[0], n_words, MPI_UINT64_T, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// waiting for the operations on the first row
+		MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+		// If the process has a single row, the row below the first one is the bottom ghost row
+		if (my_chunk == 1){
+			MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+			MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		}
+
+		// Evolution of the first row (it's only xsize/64 words, so no omp here)
+		packed_evolve_row(&current_grid[0], &current_grid[n_words], &current_grid[2*n_words], &next_grid[n_words], xsize);
+
+		// Sending the fist line. The tag is 1
+		MPI_Isend(&next_grid[n_words], n_words, MPI_UINT64_T, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+		// Receving the new top ghost row in the next grid. The tag is 0
+		MPI_Irecv(&next_grid[0], n_words, MPI_UINT64_T, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+		// Waiting for the operations on the last row
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+		// Evolution of the last row (if it's not also the first one)
+		if (my_chunk > 1){
+			packed_evolve_row(&current_grid[(my_chunk-1)*n_words], &current_grid[my_chunk*n_words], &current_grid[(my_chunk+1)*n_words], &next_grid[my_chunk*n_words], xsize);
+		}
+
+		// Sending the last row. The tag is 0
+		MPI_Isend(&next_grid[my_chunk*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+		// Receving the new bottom ghost row in the next grid. The tag is 1
+		MPI_Irecv(&next_grid[(my_chunk+1)*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+
+		// Parallel evolution of the central rows.
+		// Each row is only xsize/8 bytes, so the rows are divided in static blocks between the threads.
+		#pragma omp parallel for schedule( static )
+		for(int y=1; y<my_chunk-1; y++){
+			packed_evolve_row(&current_grid[y*n_words], &current_grid[(y+1)*n_words], &current_grid[(y+2)*n_words], &next_grid[(y+1)*n_words], xsize);
+		}
+
+		// Writing the snapshot file (with the state of the current generation, like in static_evolution)
+		if((gen % s == 0) && (s != n)){
+			#pragma omp parallel for schedule( static )
+			for (int y=0; y<my_chunk; y++){
+				unpack_row(&current_grid[(y+1)*n_words], &snap_grid[y*xsize], xsize);
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_packed/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+		// Swapping the grids
+		tmp_grid = current_grid;
+		current_grid = next_grid;
+		next_grid = tmp_grid;
+
+	} // End cycle on gen
+
+	// Deallocating all the handles
+	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file with the final state. As in static_evolution, the snapshot labelled n has the state
+	// of the generation n-1, which after the last swap is in next_grid
+	if(s == n){
+		#pragma omp parallel for schedule( static )
+		for (int y=0; y<my_chunk; y++){
+			unpack_row(&next_grid[(y+1)*n_words], &snap_grid[y*xsize], xsize);
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_packed/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	if (current_grid != NULL)
+		free(current_grid);
+	if (next_grid != NULL)
+		free(next_grid);
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	return;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static inline __attribute__((always_inline)) void packed_ordered_row_rule(uint64_t *up_row, uint64_t *my_row, uint64_t *down_row, int xsize, unsigned int birth, unsigned int survive){
+
+	// Ordered evolution of my_row, in place: the cells are evolved from left to right, so each cell sees the new state
+	// of the row above (already evolved) and of the cell on its left, and the old state of the other neighbours.
+	// The row above must already be evolved, the row below not.
+	// In a word the new states are computed for all the 64 cells with packed_rule, as in the static evolution, but
+	// only the first cell that changes state (the lowest bit of the flips) is certainly right: the cells after it
+	// were computed with its old state. So that cell is flipped and the word is computed again for the cells after it,
+	// until no other cell changes. The word is computed once more for each cell that changes state, and the number
+	// of neighbours is never stored (the counts come from the bits of the three rows each time).
+
+	int n_words = (xsize + 63) / 64;
+	int last_bit = (xsize - 1) % 64;  // position of the last cell of the row in the last word
+	uint64_t last_mask = (last_bit == 63) ? ~(uint64_t)0 : (((uint64_t)1 << (last_bit + 1)) - 1);
+
+	uint64_t left_in_up, left_in_my, left_in_down;     // bits that enter from the left
+	uint64_t right_in_up, right_in_my, right_in_down;  // bits that enter from the right
+	uint64_t my_current, my_new, flips, first_flip;
+	uint64_t pending;                                  // cells of the word not evolved yet
+
+	for (int w=0; w<n_words; w++){
+
+		if (w == 0){  // Taking the last cell of the row (still in the old state)
+			left_in_up = (up_row[n_words-1] >> last_bit) & 1;
+			left_in_my = (my_row[n_words-1] >> last_bit) & 1;
+			left_in_down = (down_row[n_words-1] >> last_bit) & 1;
+		}else{        // Taking the last cell of the previous word (already evolved)
+			left_in_up = up_row[w-1] >> 63;
+			left_in_my = my_row[w-1] >> 63;
+			left_in_down = down_row[w-1] >> 63;
+		}
+		if (w == n_words-1){  // Taking the first cell of the row (already evolved)
+			right_in_up = (up_row[0] & 1) << last_bit;
+			right_in_my = (my_row[0] & 1) << last_bit;
+			right_in_down = (down_row[0] & 1) << last_bit;
+		}else{
+			right_in_up = up_row[w+1] << 63;
+			right_in_my = my_row[w+1] << 63;
+			right_in_down = down_row[w+1] << 63;
+		}
+
+		my_current = my_row[w];
+		pending = (w == n_words-1) ? last_mask : ~(uint64_t)0;
+		while (pending != 0){
+			if (n_words == 1){
+				// The first and the last cell are in this word: the last cell is seen by the first one
+				// before any change, the first cell by the last one after its change
+				left_in_my = (my_current >> last_bit) & 1;
+				right_in_my = (my_current & 1) << last_bit;
+			}
+			my_new = packed_rule((up_row[w] << 1) | left_in_up, up_row[w], (up_row[w] >> 1) | right_in_up,
+			                     (my_current << 1) | left_in_my, my_current, (my_current >> 1) | right_in_my,
+			                     (down_row[w] << 1) | left_in_down, down_row[w], (down_row[w] >> 1) | right_in_down, birth, survive);
+			flips = (my_new ^ my_current) & pending;
+			if (flips == 0)
+				break;
+			first_flip = flips & (~flips + 1);
+			my_current ^= first_flip;
+			pending &= ~(first_flip | (first_flip - 1));  // the cells after the one that changed
+		}
+		my_row[w] = my_current;
+	}
+}
+
+void packed_ordered_row(uint64_t *up_row, uint64_t *my_row, uint64_t *down_row, int xsize){
+
+	// Ordered evolution of the row with the rule in use (as in packed_evolve_row)
+
+	if (rule_birth == RULE_CONWAY_BIRTH && rule_survive == RULE_CONWAY_SURVIVE)
+		packed_ordered_row_rule(up_row, my_row, down_row, xsize, RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE);
+	else if (rule_birth == RULE_HIGHLIFE_BIRTH && rule_survive == RULE_HIGHLIFE_SURVIVE)
+		packed_ordered_row_rule(up_row, my_row, down_row, xsize, RULE_HIGHLIFE_BIRTH, RULE_HIGHLIFE_SURVIVE);
+	else if (rule_birth == RULE_DAYNIGHT_BIRTH && rule_survive == RULE_DAYNIGHT_SURVIVE)
+		packed_ordered_row_rule(up_row, my_row, down_row, xsize, RULE_DAYNIGHT_BIRTH, RULE_DAYNIGHT_SURVIVE);
+	else
+		packed_ordered_row_rule(up_row, my_row, down_row, xsize, rule_birth, rule_survive);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void packed_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Ordered evolution on a bit-packed grid. In ordered_evolution each cell is a char with its state, the state of
+	// the cell on its left (prev) and its number of neighbours (nei), and each change of state updates 8 chars.
+	// Here each cell is a bit (as in packed_static_evolution) and nei is computed when it's needed (see
+	// packed_ordered_row), so the grid is 8 times smaller and a change of state writes a single bit.
+	// The grid is evolved in place, with one ghost row on top and one on the bottom.
+	// The cells of a row depend on each other from left to right, so the rows are evolved by a single thread.
+	//
+	// The MPI communications have the same structure of ordered_evolution (with packed rows):
+	//
+	// Recv(top ghost row) (blocking)
+	// IRecv(bottom ghost row) (handle: recvbottom)
+	// 	First row
+	// ISend(first row) (handle: sendfirst)
+	//	Central rows
+	// Wait(recvbottom)
+	// Wait(sendlast)
+	// 	Last row
+	// Isend(last row) (handle: sendlast)
+	//
+	// The snapshots are the same of ordered_evolution.
+
+	int n_words = (xsize + 63) / 64;  // Number of words in a row
+
+	// Row y of the portion is stored starting from (y+1)*n_words. Row 0 and row my_chunk+1 are the ghost rows
+	uint64_t *packed_grid = (uint64_t *)malloc((my_chunk + 2) * n_words * sizeof(uint64_t));
+	uint64_t *top_ghost_row = &packed_grid[0];
+	uint64_t *bottom_ghost_row = &packed_grid[(my_chunk+1)*n_words];
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	MPI_Request initial[2]; // Handles for the initialization comm.
+	MPI_Request sendfirst = MPI_REQUEST_NULL;
+	MPI_Request sendlast = MPI_REQUEST_NULL;
+	MPI_Request recvbottom;
+
+	// Packing the portion of the grid
+	#pragma omp parallel for schedule( static )
+	for (int y=0; y<my_chunk; y++){
+		pack_row(&my_grid[y*xsize], &packed_grid[(y+1)*n_words], xsize);
+	}
+
+	// Getting the ghost rows
+	MPI_Isend(&packed_grid[n_words], n_words, MPI_UINT64_T, top_neighbour, 1, MPI_COMM_WORLD, &initial[0]);
+	MPI_Isend(&packed_grid[my_chunk*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 0, MPI_COMM_WORLD, &initial[1]);
+	MPI_Recv(bottom_ghost_row, n_words, MPI_UINT64_T, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	MPI_Recv(top_ghost_row, n_words, MPI_UINT64_T, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	MPI_Waitall(2, initial, MPI_STATUSES_IGNORE);
+
+	// Sending the rows that begin the gen cycle (as in ordered_evolution, but non-blocking)
+	if (rank == size-1){
+		MPI_Isend(&packed_grid[my_chunk*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+	}
+	if (rank != 0){
+		MPI_Isend(&packed_grid[n_words], n_words, MPI_UINT64_T, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+	}
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// The beginning of an MPI cycle is marked by the blocking receive of the upper ghost row. The tag is 0
+		MPI_Recv(top_ghost_row, n_words, MPI_UINT64_T, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+		MPI_Irecv(bottom_ghost_row, n_words, MPI_UINT64_T, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+
+		// Evolution of the first row, then it's sent. The tag is 1
+		packed_ordered_row(&packed_grid[0], &packed_grid[n_words], &packed_grid[2*n_words], xsize);
+		MPI_Isend(&packed_grid[n_words], n_words, MPI_UINT64_T, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+
+		// Evolution of the central rows
+		for (int y=1; y<my_chunk-1; y++){
+			packed_ordered_row(&packed_grid[y*n_words], &packed_grid[(y+1)*n_words], &packed_grid[(y+2)*n_words], xsize);
+		}
+
+		// Evolution of the last row, then it's sent. The tag is 0
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+		packed_ordered_row(&packed_grid[(my_chunk-1)*n_words], &packed_grid[my_chunk*n_words], &packed_grid[(my_chunk+1)*n_words], xsize);
+		MPI_Isend(&packed_grid[my_chunk*n_words], n_words, MPI_UINT64_T, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			#pragma omp parallel for schedule( static )
+			for (int y=0; y<my_chunk; y++){
+				unpack_row(&packed_grid[(y+1)*n_words], &snap_grid[y*xsize], xsize);
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+			if (rank == size-1){ // The last process will write the snapshot
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", gen);
+			}
+		}
+
+	} // End cycle on gen
+
+	// Deallocating the handles
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+	// Receiving the last messages to end the communication
+	if (rank == 0){
+		MPI_Recv(top_ghost_row, n_words, MPI_UINT64_T, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	if (rank != size-1){
+		MPI_Recv(bottom_ghost_row, n_words, MPI_UINT64_T, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file with the final state
+	if(s == n){
+		#pragma omp parallel for schedule( static )
+		for (int y=0; y<my_chunk; y++){
+			unpack_row(&packed_grid[(y+1)*n_words], &snap_grid[y*xsize], xsize);
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+		if (rank == size-1){ // The last process will write the snapshot
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", n-1);
+		}
+	}
+
+	if (packed_grid != NULL)
+		free(packed_grid);
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	return;
+}
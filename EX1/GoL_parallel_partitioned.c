@@ -0,0 +1,434 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "mpi.h"
+#include "GoL_parallel_init_evol.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_partitioned.h"
+#include <omp.h>
+
+// The first and the last row are split in partitions of PARTITION_CELLS cells (a block of the padded kernel), starting
+// from the first cell: the partitions of a row cover its cells and its right ghost column, and they always end inside
+// the row (see the layout in GoL_parallel_grid.c). The left ghost column is not sent, the slices don't read it.
+#define PARTITION_CELLS 64
+
+// A boundary row (sent) or a ghost row (received) split in partitions. The partitions are grouped in slices, the
+// consecutive partitions evolved by a single omp thread: a slice is made ready or is waited for as a whole.
+//
+// With MPI 4 the row is a partitioned communication (MPI_Psend_init/MPI_Precv_init, one partition per block of cells),
+// the threads mark their partitions with MPI_Pready_range and the receiver checks them with MPI_Parrived.
+// With an older MPI each slice is a message on its own (tag + 2*slice), sent with MPI_Isend when it's ready and
+// received with MPI_Irecv: the structure of the partitions is the same, only with coarser messages.
+// The MPI 4 branch has never been compiled nor run: the library of the cluster (Open MPI 4.1) reports MPI_VERSION 3,
+// so the message per slice is the only version that has been built and checked.
+typedef struct {
+	unsigned char *row;     // first cell of the row
+	int send;               // 1 for a boundary row, 0 for a ghost row
+	int n_slices;
+	int *slice_start;       // first partition of each slice (n_slices+1 entries, the last one is the number of partitions)
+	int peer;
+	int tag;
+	int finished;           // send side: how many of the first and the last slice are evolved
+	char *arrived;          // receive side: slices already arrived
+#if MPI_VERSION >= 4
+	MPI_Request request;
+#else
+	MPI_Request *requests;  // one message per slice
+#endif
+} partitioned_row;
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void partitioned_row_init(partitioned_row *p, unsigned char *row, int send, int n_slices, int *slice_start, int peer, int tag){
+
+	p->row = row;
+	p->send = send;
+	p->n_slices = n_slices;
+	p->slice_start = slice_start;
+	p->peer = peer;
+	p->tag = tag;
+	p->finished = 0;
+	// The ghost rows of the first generation are exchanged before the evolution
+	p->arrived = (char *)malloc(n_slices);
+	for (int j=0; j<n_slices; j++){
+		p->arrived[j] = 1;
+	}
+#if MPI_VERSION >= 4
+	int n_partitions = slice_start[n_slices];
+	if (send){
+		MPI_Psend_init(row, n_partitions, PARTITION_CELLS, MPI_UNSIGNED_CHAR, peer, tag, MPI_COMM_WORLD, MPI_INFO_NULL, &p->request);
+	}else{
+		MPI_Precv_init(row, n_partitions, PARTITION_CELLS, MPI_UNSIGNED_CHAR, peer, tag, MPI_COMM_WORLD, MPI_INFO_NULL, &p->request);
+	}
+#else
+	p->requests = (MPI_Request *)malloc(n_slices * sizeof(MPI_Request));
+	for (int j=0; j<n_slices; j++){
+		p->requests[j] = MPI_REQUEST_NULL;
+	}
+#endif
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void partitioned_row_start(partitioned_row *p){
+
+	// Starts the transfer of a generation (before any slice is made ready or is checked)
+
+	p->finished = 0;
+	memset(p->arrived, 0, p->n_slices);
+#if MPI_VERSION >= 4
+	MPI_Start(&p->request);
+#else
+	if (!p->send){
+		for (int j=0; j<p->n_slices; j++){
+			int first = p->slice_start[j] * PARTITION_CELLS;
+			int count = (p->slice_start[j+1] - p->slice_start[j]) * PARTITION_CELLS;
+			MPI_Irecv(p->row + first, count, MPI_UNSIGNED_CHAR, p->peer, p->tag + 2*j, MPI_COMM_WORLD, &p->requests[j]);
+		}
+	}
+#endif
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void partitioned_row_ready(partitioned_row *p, int j){
+
+	// The slice j of the boundary row won't be written any more in this generation
+
+#if MPI_VERSION >= 4
+	MPI_Pready_range(p->slice_start[j], p->slice_start[j+1] - 1, p->request);
+#else
+	int first = p->slice_start[j] * PARTITION_CELLS;
+	int count = (p->slice_start[j+1] - p->slice_start[j]) * PARTITION_CELLS;
+	MPI_Isend(p->row + first, count, MPI_UNSIGNED_CHAR, p->peer, p->tag + 2*j, MPI_COMM_WORLD, &p->requests[j]);
+#endif
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static int partitioned_row_arrived(partitioned_row *p, int j){
+
+	// Checks (without waiting) if the slice j of the ghost row is arrived
+
+	if (!p->arrived[j]){
+		int flag = 1;
+#if MPI_VERSION >= 4
+		for (int i=p->slice_start[j]; i<p->slice_start[j+1] && flag; i++){
+			MPI_Parrived(p->request, i, &flag);
+		}
+#else
+		MPI_Test(&p->requests[j], &flag, MPI_STATUS_IGNORE);
+#endif
+		p->arrived[j] = flag;
+	}
+	return p->arrived[j];
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void partitioned_row_wait(partitioned_row *p){
+
+	// Completes the transfer of the generation (a request never started is completed at once)
+
+#if MPI_VERSION >= 4
+	MPI_Wait(&p->request, MPI_STATUS_IGNORE);
+#else
+	MPI_Waitall(p->n_slices, p->requests, MPI_STATUSES_IGNORE);
+#endif
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void partitioned_row_free(partitioned_row *p){
+#if MPI_VERSION >= 4
+	MPI_Request_free(&p->request);
+#else
+	free(p->requests);
+#endif
+	free(p->arrived);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static int wait_ghost_slices(partitioned_row *ghost, int j){
+
+	// Spins until the slices of the ghost row read by the slice j of the boundary row are arrived: the slice itself,
+	// the ones on its sides (for the cells x-1 and x+1 at its ends) and, for the first and the last slice, the one at
+	// the other end of the row (the wrap on the columns). The MPI calls of the threads are serialized by the critical
+	// section. Returns 1 if the thread had to wait.
+
+	int last = ghost->n_slices - 1;
+	int needed[4] = {j - 1, j, j + 1, (j == 0) ? last : ((j == last) ? 0 : -1)};
+	int waited = 0;
+	int tries = 0;
+
+	for (int i=0; i<4; i++){
+		if (needed[i] < 0 || needed[i] >= ghost->n_slices){
+			continue;
+		}
+		int arrived;
+		#pragma omp critical (partitioned_mpi)
+		arrived = partitioned_row_arrived(ghost, needed[i]);
+		while (!arrived){
+			waited = 1;
+			tries++;
+			if (tries > 1000){
+				sched_yield();
+				tries = 0;
+			}
+			#pragma omp critical (partitioned_mpi)
+			arrived = partitioned_row_arrived(ghost, needed[i]);
+		}
+	}
+	return waited;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static int boundary_slice(partitioned_row *out, partitioned_row *ghost, unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, int j, unsigned char current, unsigned char next){
+
+	// Evolves the slice j of a boundary row (my_row, sent by out) as soon as the ghost row (up_row or down_row,
+	// received by ghost) has arrived around it, then makes it ready.
+	// The last slice holds the right ghost column, the copy of the first cell: it's made ready, with the ghost
+	// columns filled, by the thread that finishes the second between the first and the last slice.
+	// Returns 1 if the thread had to wait for the ghost row.
+
+	int waited = wait_ghost_slices(ghost, j);
+	int last = out->n_slices - 1;
+
+	// The cells of the slice, in the whole row: the neighbours wrap on the columns of the row, so the ghost columns
+	// of the ghost row are not needed (the padded kernel would take the slice for a row and wrap at its ends)
+	int x0 = out->slice_start[j] * PARTITION_CELLS;
+	int x1 = out->slice_start[j+1] * PARTITION_CELLS;
+	if (x1 > xsize){
+		x1 = xsize;
+	}
+	static_evolve_segment(up_row, my_row, down_row, x0, x1, xsize, current, next);
+
+	#pragma omp critical (partitioned_mpi)
+	{
+		if (j != last){
+			partitioned_row_ready(out, j);
+		}
+		if (j == 0 || j == last){
+			out->finished++;
+			if (out->finished == ((last == 0) ? 1 : 2)){
+				halo_fill_columns(my_row, xsize);
+				partitioned_row_ready(out, last);
+			}
+		}
+	}
+	return waited;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void partitioned_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution (in-place, as static_evolution) where the first and the last row are split in slices, one for
+	// each omp thread, and each slice travels on its own: a thread makes its slice ready as soon as it's evolved,
+	// without waiting for the rest of the row, and on the other side a slice of the first (last) row is evolved as soon
+	// as the slices of the ghost row around it have arrived, without waiting for the whole row.
+	// The threads that are done with the boundary rows go on with the central rows (which read only the "current"
+	// bit of the boundary rows, the one that is not written in this generation).
+	// With MPI 4 the rows are partitioned communications, otherwise each slice is a message (see partitioned_row).
+	//
+	// Since a process with a single row would send and receive on the same row, if any process has less than 2 rows
+	// all of them use static_evolution.
+
+	// MPI communications stucture:
+	//
+	// Wait(sendfirst, sendlast)
+	// Start(sendfirst, sendlast)
+	// 	omp for (slices of the first and of the last row):
+	// 		Parrived(recvtop / recvbottom) on the slices around
+	// 		Slice of the row
+	// 		Pready(sendfirst / sendlast)
+	// 	omp for: Central rows
+	// Wait(recvtop, recvbottom)
+	// Start(recvtop, recvbottom)
+	// Writing snapshots
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int min_chunk;
+	MPI_Allreduce(&my_chunk, &min_chunk, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+	if (min_chunk < 2){
+		if (rank == 0){
+			fprintf(stderr, "Partitioned halos need at least 2 rows per process, using the default static evolution\n");
+		}
+		static_evolution(my_grid, grid, num_cells, displs, xsize, my_chunk, n, s);
+		return;
+	}
+
+	halo_grid halo;
+	halo_grid_init(&halo, xsize, my_chunk);
+	halo_grid_load(&halo, my_grid);
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	unsigned char *top_ghost_row = halo_row(&halo, -1);
+	unsigned char *first_row = halo_row(&halo, 0);
+	unsigned char *last_row = halo_row(&halo, my_chunk - 1);
+	unsigned char *bottom_ghost_row = halo_row(&halo, my_chunk);
+	int padded_xsize = xsize + 2;
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Partitions of a row (up to the right ghost column) and slices, one for each thread but each with at least
+	// one block of cells. All the processes have the same slices, the partitions of the receiver match the sender.
+	int n_partitions = (halo.stride - 64) / PARTITION_CELLS;
+	int cell_blocks = (xsize + PARTITION_CELLS - 1) / PARTITION_CELLS;
+	int n_slices = omp_get_max_threads();
+	if (n_slices > cell_blocks){
+		n_slices = cell_blocks;
+	}
+	int *slice_start = (int *)malloc((n_slices + 1) * sizeof(int));
+	for (int j=0; j<n_slices; j++){
+		slice_start[j] = (int)((long int)j * cell_blocks / n_slices);
+	}
+	slice_start[n_slices] = n_partitions;
+
+	// Sharing the ghost rows to start the generations (whole rows, with the ghost columns)
+	MPI_Request setup[4];
+	MPI_Isend(first_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &setup[0]);
+	MPI_Isend(last_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &setup[1]);
+	MPI_Irecv(bottom_ghost_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &setup[2]);
+	MPI_Irecv(top_ghost_row - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &setup[3]);
+	MPI_Waitall(4, setup, MPI_STATUSES_IGNORE);
+
+	// The first row goes to the top neighbour with tag 1, the last row to the bottom neighbour with tag 0
+	partitioned_row sendfirst, sendlast, recvtop, recvbottom;
+	partitioned_row_init(&sendfirst, first_row, 1, n_slices, slice_start, top_neighbour, 1);
+	partitioned_row_init(&sendlast, last_row, 1, n_slices, slice_start, bottom_neighbour, 0);
+	partitioned_row_init(&recvtop, top_ghost_row, 0, n_slices, slice_start, top_neighbour, 0);
+	partitioned_row_init(&recvbottom, bottom_ghost_row, 0, n_slices, slice_start, bottom_neighbour, 1);
+
+	// Alternating positions of the current and next states of the system
+	char current = 1;
+	char next = 2;
+	long int waits = 0;
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// The value of current and next alternate between 1 and 2 (first and second bit)
+		current = gen % 2 + 1;
+		next = 2 - gen % 2;
+
+		// The boundary rows are written again only after their last transfer is completed
+		partitioned_row_wait(&sendfirst);
+		partitioned_row_wait(&sendlast);
+		partitioned_row_start(&sendfirst);
+		partitioned_row_start(&sendlast);
+
+		#pragma omp parallel reduction(+:waits)
+		{
+			// Slices of the first and of the last row, in the order in which the ghost rows are likely to arrive
+			#pragma omp for schedule(dynamic, 1) nowait
+			for (int i=0; i<2*n_slices; i++){
+				if (i < n_slices){
+					waits += boundary_slice(&sendfirst, &recvtop, top_ghost_row, first_row, halo_row(&halo, 1), xsize, i, current, next);
+				}else{
+					waits += boundary_slice(&sendlast, &recvbottom, halo_row(&halo, my_chunk - 2), last_row, bottom_ghost_row, xsize, i - n_slices, current, next);
+				}
+			}
+
+			// Parallel evolution of the central rows
+			#pragma omp for schedule(static)
+			for(int y=1; y<my_chunk-1; y++){
+				static_evolve_padded_row(halo_row(&halo, y-1), halo_row(&halo, y), halo_row(&halo, y+1), xsize, current, next);
+				halo_fill_columns(halo_row(&halo, y), xsize);
+			}
+		} // end omp parallel
+
+		// All the slices of the ghost rows have been read: they are received again for the next generation
+		partitioned_row_wait(&recvtop);
+		partitioned_row_wait(&recvbottom);
+		partitioned_row_start(&recvtop);
+		partitioned_row_start(&recvbottom);
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			for (int y=0; y<my_chunk; y++){
+				for (int x=0; x<xsize; x++){
+					snap_grid[y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+				}
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+	} // End cycle on gen
+
+	// The receptions started after the last generation match the last sends
+	partitioned_row_wait(&sendfirst);
+	partitioned_row_wait(&sendlast);
+	partitioned_row_wait(&recvtop);
+	partitioned_row_wait(&recvbottom);
+	partitioned_row_free(&sendfirst);
+	partitioned_row_free(&sendlast);
+	partitioned_row_free(&recvtop);
+	partitioned_row_free(&recvbottom);
+
+	long int total_waits = 0;
+	MPI_Reduce(&waits, &total_waits, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0){
+#if MPI_VERSION >= 4
+		const char *transport = "partitioned requests";
+#else
+		const char *transport = "a message per slice";
+#endif
+		fprintf(stderr, "Partitioned halos (%s): %d partitions, %d slices per row, waited for %ld of %ld slices\n",
+		        transport, n_partitions, n_slices, total_waits, 2L * n_slices * n * size);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file
+	if(s == n){
+		for (int y=0; y<my_chunk; y++){
+			for (int x=0; x<xsize; x++){
+				snap_grid[y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+			}
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+	free(snap_grid);
+	free(slice_start);
+
+	// The process keeps its rows in my_grid
+	halo_grid_store(&halo, my_grid);
+	halo_grid_free(&halo);
+}
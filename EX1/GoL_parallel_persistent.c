@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_init_evol.h"
+#include <omp.h>
+
+// Progress flag of a thread. Each flag is on its own cache line to avoid false sharing between threads
+typedef struct {
+	atomic_int value;
+	char padding[64 - sizeof(atomic_int)];
+} flag_t;
+
+static void wait_flag(flag_t *flag, int value){
+
+	// Spins until the flag reaches value. After many tries it also yields the core,
+	// in case there are more threads than cores.
+
+	int tries = 0;
+	while (atomic_load_explicit(&flag->value, memory_order_acquire) < value){
+		tries++;
+		if (tries > 1000){
+			sched_yield();
+			tries = 0;
+		}
+	}
+}
+
+static void set_flag(flag_t *flag, int value){
+	atomic_store_explicit(&flag->value, value, memory_order_release);
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void persistent_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution with a single omp parallel region for the whole run.
+	// In static_evolution every generation opens three parallel regions (first row, last row, central rows),
+	// and the fork/join and the implicit barriers have a cost at each generation.
+	// Here each thread owns a fixed band of rows and a thread can start a new generation as soon as
+	// the two threads with the adjacent bands have completed the previous one (they are the only ones that read
+	// and write rows near its band). This is done with a progress flag for each thread instead of a barrier.
+	// The encoding is the same of static_evolution (the state alternates between bit 1 and bit 2).
+	//
+	// Only the master thread (thread 0, which owns the first row) calls MPI (MPI_THREAD_FUNNELED).
+	// The last thread, which owns the last row, signals to the master when the last row is ready
+	// and the master sends it as soon as it sees the signal (it checks after each row of its band).
+	//
+	// Generation structure:
+	//
+	// Master thread:
+	// 	Wait(sendfirst, recvtop)
+	// 	First row
+	// 	isend/irecv(sendfirst, recvtop)
+	// 	Wait(sendlast, recvbottom)  ->  bottom_ready
+	// 	Its other rows (isend/irecv(sendlast, recvbottom) when last_row_done)
+	// Last thread:
+	// 	wait bottom_ready
+	// 	Last row  ->  last_row_done
+	// 	Its other rows
+	// Other threads:
+	// 	Their rows
+	// All threads wait only for the threads with the adjacent bands (done flags)
+
+	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Each thread needs at least one row
+	int n_threads = omp_get_max_threads();
+	if (n_threads > my_chunk)
+		n_threads = my_chunk;
+
+	flag_t *done = (flag_t *)aligned_alloc(64, n_threads * sizeof(flag_t)); // number of generations completed by each thread
+	flag_t bottom_ready;   // generation in which the last row can be evolved (bottom ghost row received and last row sent)
+	flag_t last_row_done;  // number of generations completed on the last row
+	for (int t=0; t<n_threads; t++){
+		atomic_init(&done[t].value, 0);
+	}
+	atomic_init(&bottom_ready.value, -1);
+	atomic_init(&last_row_done.value, 0);
+
+	char current;
+	char next;
+
+	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
+
+	// Sharing the ghost rows to start the generations
+
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0,MPI_COMM_WORLD, &recvtop);
+
+	#pragma omp parallel num_threads( n_threads ) private(current, next)
+	{
+		int t = omp_get_thread_num();
+		int last = n_threads - 1;
+		// Band of rows of the thread: from y_start to y_end-1
+		int y_start = (int)((long int)t * my_chunk / n_threads);
+		int y_end = (int)((long int)(t + 1) * my_chunk / n_threads);
+		int last_row_sent = 0;  // (master only) number of generations in which the last row was sent
+
+		unsigned char *up_row, *down_row;
+
+		for (int gen=0; gen<n; gen++) {
+
+			// Alternating positions of the current and next states of the system
+			current = gen % 2 + 1;
+			next = 2 - gen % 2;
+
+			// Waiting for the threads of the adjacent bands to complete the previous generation
+			if (t > 0)
+				wait_flag(&done[t-1], gen);
+			if (t < last)
+				wait_flag(&done[t+1], gen);
+
+			if (t == 0){
+				// waiting for the operations on the first row
+				MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+				MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+
+				// Evolution of the first row (if the process has a single row, also the bottom ghost row is needed)
+				if (my_chunk == 1){
+					MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+					MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+				}
+				down_row = (my_chunk == 1) ? bottom_ghost_row : &my_grid[xsize];
+				static_evolve_row(top_ghost_row, &my_grid[0], down_row, xsize, current, next);
+
+				// Sending the fist line. The tag is 1
+				MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+				// Receving the new top_ghost_row. The tag is 0
+				MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+				// Waiting for the operations on the last row and letting the last thread evolve it
+				if (my_chunk > 1){
+					MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+					MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+					set_flag(&bottom_ready, gen);
+				}else{
+					set_flag(&last_row_done, gen + 1);
+				}
+				last_row_sent = gen;
+			}
+
+			if (t == last && my_chunk > 1){
+				// Evolution of the last row
+				wait_flag(&bottom_ready, gen);
+				up_row = &my_grid[(my_chunk - 2) * xsize];
+				static_evolve_row(up_row, &my_grid[(my_chunk - 1) * xsize], bottom_ghost_row, xsize, current, next);
+				set_flag(&last_row_done, gen + 1);
+			}
+
+			// Evolution of the other rows of the band
+			for (int y=y_start; y<y_end; y++){
+				if (y == 0 || y == my_chunk - 1)
+					continue;
+				static_evolve_row(&my_grid[(y-1)*xsize], &my_grid[y*xsize], &my_grid[(y+1)*xsize], xsize, current, next);
+
+				// The master sends the last row as soon as it's ready
+				if (t == 0 && last_row_sent == gen && atomic_load_explicit(&last_row_done.value, memory_order_acquire) > gen){
+					// Sending the last row. The tag is 0
+					MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+					// Receving the new bottom_ghost_row. The tag is 1
+					MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+					last_row_sent = gen + 1;
+				}
+			}
+
+			if (t == 0 && last_row_sent == gen){
+				// The last row was not ready during the work on the band
+				wait_flag(&last_row_done, gen + 1);
+				MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+				MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+				last_row_sent = gen + 1;
+			}
+
+			set_flag(&done[t], gen + 1);
+
+			// Writing the snapshot file. Here all the threads must stop, since in the next generation
+			// the bit with the current state will be overwritten.
+			if((gen % s == 0) && (s != n)){
+				#pragma omp barrier
+				#pragma omp for schedule( static )
+				for (int i=0; i<xsize*my_chunk; i++){
+					//snap_grid will have the value of the grid at the current state
+					snap_grid[i] = ((my_grid[i] & current) == current);
+				}
+				#pragma omp master
+				{
+					MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+					if (rank == 0){
+						write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+					}
+					MPI_Barrier(MPI_COMM_WORLD);
+				}
+				#pragma omp barrier
+			}
+
+		} // End cycle on gen
+	} // End of the parallel region
+
+	// Deallocating all the handles
+	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file (like in static_evolution)
+	if(s == n){
+		current = (n - 1) % 2 + 1;  // current state of the last generation
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = ((my_grid[i] & current) == current);
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	if (top_ghost_row != NULL)
+		free(top_ghost_row);
+	if (bottom_ghost_row != NULL)
+		free(bottom_ghost_row);
+	if (snap_grid != NULL)
+		free(snap_grid);
+	if (done != NULL)
+		free(done);
+
+	return;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static int l_ind_validate(unsigned char *my_grid, int y, int xsize, int count, int *l_ind_pos, int *l_ind_dist){
+
+	// Checks again the line_independent points of the row y+1 found by l_ind before the end of the row y
+	// (the values of the row y+1 change while the row y is evolved). The points that are not line_independent
+	// anymore are removed and their fragment is joined to the previous one. Returns the new count.
+
+	unsigned char val;
+	int valid = 1;  // the first point is the first cell of the row
+	for (int i=1; i<count; i++){
+		val = my_grid[(y+1)*xsize + l_ind_pos[i]];
+		if (l_ind_point(val)){
+			l_ind_pos[valid] = l_ind_pos[i];
+			l_ind_dist[valid] = l_ind_dist[i];
+			valid++;
+		}else{
+			l_ind_dist[valid-1] += l_ind_dist[i];
+		}
+	}
+	return valid;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void persistent_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Ordered evolution with a single omp parallel region for the whole run.
+	// In ordered_evolution the parallel for is inside the loop on the rows, so each central row has a fork/join,
+	// and after the join the master alone fixes the fragments and searches the line_independent points of the next row.
+	// Here the threads stay in the same team and move from a row to the next one with a progress flag (stage),
+	// which counts the rows made available to the team:
+	// - each thread evolves the fragments i = t, t+n_threads, ... of the row (like schedule(static, 1));
+	// - the first thread that completes its fragments searches the line_independent points of the next row
+	//   while the others are still working (the values of the next row can still change, so they are only candidates);
+	// - the last thread that completes its fragments fixes the fragments, checks the candidates with the final
+	//   values of the next row (l_ind_validate) and makes the next row available.
+	// The fragments of a row and the order of the rows are the same of ordered_evolution, and so the results.
+	// The line_independent points of two rows are kept, in two pairs of arrays (the row y uses the pair y%2).
+	//
+	// Only the master thread calls MPI, and it evolves the first and the last row (as in ordered_evolution):
+	//
+	// Master thread:
+	// 	Recv(top_ghost_row), First row, Isend(first row)
+	// 	l_ind of the row 1  ->  stage
+	// All threads:
+	// 	Central rows (wait stage, fragments, last thread  ->  stage)
+	// Master thread:
+	// 	Wait(recvbottom), Last row, Isend(last row)
+	// 	Writing snapshots
+
+	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	int stride = 640;  // The minimum size of the fragment of the row in which a thread will work
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	int n_threads = omp_get_max_threads();
+
+	// Line_independent points of two rows (positions and distances, see l_ind)
+	int *l_ind_pos[2], *l_ind_dist[2];
+	int count[2];
+	for (int b=0; b<2; b++){
+		l_ind_pos[b] = (int *)malloc(((xsize/stride)+1) * sizeof(int));
+		l_ind_dist[b] = (int *)malloc(((xsize/stride)+1) * sizeof(int));
+	}
+
+	flag_t stage;       // number of times a row was made available to the team (or the central rows were completed)
+	flag_t candidates;  // stage in which the candidates of the next row are ready
+	flag_t finished;    // threads that completed their fragments of the current row
+	atomic_init(&stage.value, 0);
+	atomic_init(&candidates.value, 0);
+	atomic_init(&finished.value, 0);
+
+	MPI_Request initial[2]; // Handle for the initialization comm.
+	MPI_Request sendlast = MPI_REQUEST_NULL; // Initialized requestS to not get stuck in the wait
+	MPI_Request sendfirst = MPI_REQUEST_NULL;
+	MPI_Request recvbottom;
+
+	// Getting the ghost rows
+	
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &initial[0]);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &initial[1]);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Recv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	// Wait for both routines to complete
+	MPI_Waitall(2, initial, MPI_STATUSES_IGNORE);
+
+	// Initializing the grid to get the right value of prev and nei for all cells 
+	ordered_encode(my_grid, xsize, my_chunk, top_ghost_row, bottom_ghost_row);
+
+	// Sending the bottom row of the last MPI process to begin the gen cycle. The tag is 0
+	if (rank == size-1){
+		MPI_Send(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD);
+	}
+	// Also the top row of each MPI process (except the fist one!) should be sent for the cycle to begin. The tag is 1
+	if (rank != 0){
+		MPI_Send(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD);
+	}
+
+	#pragma omp parallel num_threads( n_threads )
+	{
+		int t = omp_get_thread_num();
+		int seen = 0;  // stages seen by the thread
+		int b;         // pair of arrays of the row
+
+		for (int gen=0; gen<n; gen++) {
+
+			if (t == 0){
+				// The beginning of an MPI cycle is marked by the blocking receive of the upper ghost row. The tag is 0
+				MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+				MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+				// From the beginning we ask for the bottom ghost row, but we put a wait only on the last line. The tag is 1
+				MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1 , MPI_COMM_WORLD, &recvbottom);
+
+				// Updating the first line (no parallelization)
+				ordered_first_row(my_grid, top_ghost_row, xsize);
+
+				// Sending the fist line. The tag is 1
+				MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+
+				// Creating the arrays of the line_independent points of the row 1 and making it available
+				if (my_chunk > 2){
+					count[1] = l_ind(my_grid, 0, xsize, stride, l_ind_pos[1], l_ind_dist[1]);
+					set_flag(&stage, seen + 1);
+				}
+			}
+
+			// Updating the central lines ( PARALLELIZATION )
+
+			for (int y = 1; y < my_chunk-1; y++){
+				seen++;
+				wait_flag(&stage, seen);
+				b = y % 2;
+
+				for (int i = t; i<count[b]; i+=n_threads){
+					ordered_fragment(my_grid, y, xsize, l_ind_pos[b][i], l_ind_dist[b][i], i == 0);
+				}
+
+				int done = atomic_fetch_add_explicit(&finished.value, 1, memory_order_acq_rel) + 1;
+
+				// The first thread that completes its fragments looks for the candidates of the next row
+				if (done == 1 && y + 1 < my_chunk - 1){
+					count[1-b] = l_ind(my_grid, y, xsize, stride, l_ind_pos[1-b], l_ind_dist[1-b]);
+					set_flag(&candidates, seen);
+				}
+
+				// The last thread completes the row and makes the next one available
+				if (done == n_threads){
+					ordered_fix_fragments(my_grid, y, xsize, count[b], l_ind_pos[b], l_ind_dist[b]);
+					if (y + 1 < my_chunk - 1){
+						wait_flag(&candidates, seen);
+						count[1-b] = l_ind_validate(my_grid, y, xsize, count[1-b], l_ind_pos[1-b], l_ind_dist[1-b]);
+					}
+					atomic_store_explicit(&finished.value, 0, memory_order_relaxed);
+					set_flag(&stage, seen + 1);  // the next row, or the end of the central rows
+				}
+			}// End of iteration on central line
+			if (my_chunk > 2)
+				seen++;  // stage of the end of the central rows
+
+			if (t == 0){
+				wait_flag(&stage, seen);
+
+				// Waiting for the bottom ghost row to arrive
+				MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+				MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+				// Updating the last line (no parallelization)
+				ordered_last_row(my_grid, bottom_ghost_row, xsize, my_chunk);
+
+				// The MPI cycle ends by sending the last row, without it the bottom neighbour. The tag is 0
+				MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+
+				// Writing the snapshot file
+				if((gen % s == 0) && (s != n)){
+					//writing the temporary grid
+					for (int i=0; i<xsize*my_chunk; i++){
+						//snap_grid will have the value of the grid at the current state
+						snap_grid[i] = my_grid[i] & 1;
+					}
+
+					MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+
+					if (rank == size-1){ // The last process will write the snapshot
+						write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", gen);
+					}
+				}
+			}
+
+		} // End cycle on gen
+	} // End of the parallel region
+
+	// Deallocating the handles
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+	// Receiving the last messages to end the communication
+	if (rank == 0){
+		MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	if (rank != size-1){
+		MPI_Recv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	if(s == n){
+		//writing the temporary grid
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = my_grid[i] & 1;
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+		if (rank == size-1){ // The last process will write the snapshot
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", n-1);
+		}
+	}
+
+	if (top_ghost_row != NULL)
+		free(top_ghost_row);
+	if (bottom_ghost_row != NULL)
+		free(bottom_ghost_row);
+	if (snap_grid != NULL)
+		free(snap_grid);
+	for (int b=0; b<2; b++){
+		free(l_ind_pos[b]);
+		free(l_ind_dist[b]);
+	}
+
+	return;
+}
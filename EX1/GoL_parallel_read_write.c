@@ -67,7 +67,7 @@ void read_pgm_image( void **image, int *maxval, int *xsize, int *ysize, const ch
 	*image = NULL;
 	*xsize = *ysize = *maxval = 0;
 
-	char    MagicN[2];
+	char    MagicN[3];
 	char   *line = NULL;
 	size_t  k, n = 0;
 
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_shm.h"
+#include <immintrin.h>  // _mm_sfence
+#include <omp.h>
+
+// Segment of a process in the shared window of its node:
+//
+// 	| padding to 64 bytes | progress flag (64 bytes) | halo grid 0 | halo grid 1 |
+//
+// The windows are allocated with alloc_shared_noncontig, so each segment is mapped at the beginning of a page in
+// every process and the padding is the same for all the processes that see it.
+#define SHM_FLAG_BYTES 64
+
+// Progress flag of a process: number of generations it has completed
+typedef struct {
+	atomic_int value;
+	char padding[SHM_FLAG_BYTES - sizeof(atomic_int)];
+} shm_flag_t;
+
+// What a process knows of a neighbour: its flag and its rows, if it's on the same node (NULL otherwise)
+typedef struct {
+	shm_flag_t *flag;
+	unsigned char *rows[2];  // the row read by the process (the last or the first of the neighbour) in the two grids
+} shm_neighbour;
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static unsigned char * shm_segment_layout(unsigned char *base, int xsize, int rows, shm_flag_t **flag, halo_grid *grids){
+
+	// Places the flag and the two halo grids in the segment that begins at base (see above). With base NULL
+	// it only computes the size of the segment, which is returned as an address from NULL.
+
+	int stride = 64 + ((xsize + 1 + 63) / 64) * 64;  // as in halo_grid_init
+	unsigned char *p = (unsigned char *)(((uintptr_t)base + 63) & ~(uintptr_t)63);
+
+	*flag = (shm_flag_t *)p;
+	p += SHM_FLAG_BYTES;
+	for (int i=0; i<2; i++){
+		grids[i].memory = p;
+		grids[i].xsize = xsize;
+		grids[i].rows = rows;
+		grids[i].halo = 1;
+		grids[i].stride = stride;
+		p += (size_t)(rows + 2) * stride;
+	}
+	return p;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void wait_neighbour(shm_neighbour *neighbour, int value, MPI_Win win){
+
+	// Spins until the neighbour on the same node has completed value generations. MPI_Win_sync makes the stores of the
+	// neighbour visible (unified memory model). After many tries it also yields the core, as in GoL_parallel_persistent.c
+
+	int tries = 0;
+	MPI_Win_sync(win);
+	while (atomic_load_explicit(&neighbour->flag->value, memory_order_acquire) < value){
+		tries++;
+		if (tries > 1000){
+			sched_yield();
+			tries = 0;
+		}
+		MPI_Win_sync(win);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void find_neighbour(shm_neighbour *neighbour, int world_rank, int row, int *num_cells, int xsize, MPI_Group world_group, MPI_Group node_group, MPI_Win win){
+
+	// Looks for the process world_rank in the node. If it's there, takes the address of its flag and of its row "row"
+	// (-1 for the last one) in the two grids
+
+	int node_rank;
+	MPI_Aint segment_size;
+	int disp_unit;
+	unsigned char *base;
+	shm_flag_t *flag;
+	halo_grid grids[2];
+
+	MPI_Group_translate_ranks(world_group, 1, &world_rank, node_group, &node_rank);
+	if (node_rank == MPI_UNDEFINED){
+		neighbour->flag = NULL;
+		return;
+	}
+	int rows = num_cells[world_rank] / xsize;
+	MPI_Win_shared_query(win, node_rank, &segment_size, &disp_unit, &base);
+	shm_segment_layout(base, xsize, rows, &flag, grids);
+	neighbour->flag = flag;
+	for (int i=0; i<2; i++){
+		neighbour->rows[i] = halo_row(&grids[i], (row < 0) ? rows - 1 : row);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void shm_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution with the ghost rows read directly from the memory of the neighbours on the same node.
+	// The processes of a node (MPI_COMM_TYPE_SHARED) allocate their grids in a shared window (MPI_Win_allocate_shared):
+	// each process has two halo grids with one state per char (0 or 1) swapped at each generation, as in
+	// streaming_static_evolution, and a flag with the number of generations it has completed.
+	// When a neighbour is on the same node its boundary row is passed to static_stream_row in place of the ghost row,
+	// so nothing is copied; only the neighbours on other nodes exchange the rows with messages, in the ghost rows.
+	//
+	// At the generation gen a process reads the rows of the grid gen%2 of its neighbours and writes its grid (gen+1)%2,
+	// whose boundary rows were read by the neighbours in the generation gen-1. So before writing its first and last rows
+	// a process waits until its neighbours on the node have completed gen generations: their rows of the grid gen%2
+	// are ready and they don't read the grid (gen+1)%2 anymore. The central rows don't need to wait.
+	//
+	// Structure of a generation:
+	//
+	// isend/irecv(first and last row) with the neighbours on other nodes (in the ghost rows)
+	// 	Central rows
+	// Wait(flags of the neighbours on the node >= gen)
+	// Waitall(messages)
+	// 	First and last row
+	// flag = gen+1
+	// Writing snapshots (from the source grid)
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// The processes of the node and their shared window
+	MPI_Comm node_comm;
+	MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+
+	MPI_Info info;
+	MPI_Info_create(&info);
+	MPI_Info_set(info, "alloc_shared_noncontig", "true");
+	shm_flag_t *my_flag;
+	halo_grid grids[2];
+	unsigned char *base;
+	MPI_Win win;
+	MPI_Aint segment_size = (MPI_Aint)(uintptr_t)shm_segment_layout(NULL, xsize, my_chunk, &my_flag, grids) + 63;
+	MPI_Win_allocate_shared(segment_size, 1, info, node_comm, &base, &win);
+	MPI_Info_free(&info);
+	shm_segment_layout(base, xsize, my_chunk, &my_flag, grids);
+	memset(base, 0, segment_size);
+	atomic_init(&my_flag->value, 0);
+	halo_grid_load(&grids[0], my_grid);
+
+	// Finding the neighbours on the node
+	MPI_Group world_group, node_group;
+	MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+	MPI_Comm_group(node_comm, &node_group);
+	shm_neighbour top, bottom;
+	find_neighbour(&top, top_neighbour, -1, num_cells, xsize, world_group, node_group, win);    // its last row
+	find_neighbour(&bottom, bottom_neighbour, 0, num_cells, xsize, world_group, node_group, win); // its first row
+	MPI_Group_free(&world_group);
+	MPI_Group_free(&node_group);
+
+	int local_shared = (top.flag != NULL) + (bottom.flag != NULL);
+	int shared;
+	MPI_Reduce(&local_shared, &shared, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0){
+		fprintf(stderr, "Halos in shared memory: %d of %d\n", shared, 2 * size);
+	}
+
+	// The rows of the process in a halo grid, for the snapshots
+	MPI_Datatype rows_type;
+	MPI_Type_vector(my_chunk, xsize, grids[0].stride, MPI_UNSIGNED_CHAR, &rows_type);
+	MPI_Type_commit(&rows_type);
+
+	MPI_Request requests[4];
+	int n_requests;
+	int padded_xsize = xsize + 2;
+	unsigned char *up_row, *down_row;
+
+	// All the segments are ready before they are read
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+	MPI_Win_sync(win);
+	MPI_Barrier(MPI_COMM_WORLD);
+	MPI_Win_sync(win);
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		halo_grid *source = &grids[gen % 2];
+		halo_grid *destination = &grids[(gen + 1) % 2];
+
+		// Exchanging the rows with the neighbours on other nodes
+		n_requests = 0;
+		if (top.flag == NULL){
+			// Each process sends its top row to its top neighbour (the tag is 1) and receives its top ghost row (the tag is 0)
+			MPI_Isend(halo_row(source, 0) - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &requests[n_requests++]);
+			MPI_Irecv(halo_row(source, -1) - 1, padded_xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &requests[n_requests++]);
+		}
+		if (bottom.flag == NULL){
+			// Each process sends its bottom row to its bottom neighbour (the tag is 0) and receives its bottom ghost row (the tag is 1)
+			MPI_Isend(halo_row(source, my_chunk - 1) - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &requests[n_requests++]);
+			MPI_Irecv(halo_row(source, my_chunk) - 1, padded_xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &requests[n_requests++]);
+		}
+
+		// Parallel evolution of the central rows (they read and write only the grids of the process)
+		#pragma omp parallel
+		{
+			#pragma omp for schedule( static ) nowait
+			for(int y=1; y<my_chunk-1; y++){
+				static_stream_row(halo_row(source, y-1), halo_row(source, y), halo_row(source, y+1), halo_row(destination, y), xsize);
+			}
+			_mm_sfence();
+		}// end omp parallel
+
+		// Waiting for the boundary rows of the neighbours
+		if (top.flag != NULL)
+			wait_neighbour(&top, gen, win);
+		if (bottom.flag != NULL)
+			wait_neighbour(&bottom, gen, win);
+		MPI_Waitall(n_requests, requests, MPI_STATUSES_IGNORE);
+		up_row = (top.flag != NULL) ? top.rows[gen % 2] : halo_row(source, -1);
+		down_row = (bottom.flag != NULL) ? bottom.rows[gen % 2] : halo_row(source, my_chunk);
+
+		// Evolution of the first and of the last row (if it's not also the first one)
+		static_stream_row(up_row, halo_row(source, 0), (my_chunk > 1) ? halo_row(source, 1) : down_row, halo_row(destination, 0), xsize);
+		if (my_chunk > 1){
+			static_stream_row(halo_row(source, my_chunk - 2), halo_row(source, my_chunk - 1), down_row, halo_row(destination, my_chunk - 1), xsize);
+		}
+
+		// The rows must be complete before the neighbours see the flag
+		_mm_sfence();
+		MPI_Win_sync(win);
+		atomic_store_explicit(&my_flag->value, gen + 1, memory_order_release);
+
+		// Writing the snapshot file (the state of this generation is in the source grid)
+		if((gen % s == 0) && (s != n)){
+			MPI_Gatherv((void*)halo_row(source, 0), 1, rows_type, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+	} // End cycle on gen
+
+	// Waiting for all processes before ending (no one reads the segments anymore)
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file (like in static_evolution, the state of the last generation, in the grid (n-1)%2)
+	if(s == n){
+		MPI_Gatherv((void*)halo_row(&grids[(n + 1) % 2], 0), 1, rows_type, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	// The process keeps its rows in my_grid
+	halo_grid_store(&grids[n % 2], my_grid);
+	MPI_Type_free(&rows_type);
+	MPI_Win_unlock_all(win);
+	MPI_Win_free(&win);
+	MPI_Comm_free(&node_comm);
+
+	return;
+}
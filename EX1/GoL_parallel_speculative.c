@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_init_evol.h"
+#include "GoL_parallel_speculative.h"
+#include <omp.h>
+
+// Smallest fragment of a row (a row is split in as many fragments as the omp threads, if they are long enough)
+#define SPECULATIVE_MIN_FRAGMENT 64
+
+static void speculative_fragment(unsigned char *my_grid, int y, int xsize, int x_start, int x_end, char *first_diff, char *last_diff){
+
+	// Evolves the cells from x_start to x_end-1 of the row y from left to right, like ordered_evolution, but it changes
+	// only the cells of the fragment: the rows above and below and the cells outside the fragment are updated later
+	// (see speculative_ordered_evolution). The change of state (-1, 0 or 1) of the first and the last cell is
+	// returned in first_diff and last_diff.
+	// As in ordered_fragment, only the cells found by ordered_flip_mask and the cells after a change are evolved.
+
+	unsigned char *row = &my_grid[(long int)y*xsize];
+	unsigned char val;
+	char my_current, my_new, diff;
+	uint64_t todo;     // cells of a block of 64 that must still be evolved
+	int changed = 0;   // 1 if the last cell of the previous block changed state
+	int block_size;
+	int x;
+
+	*first_diff = 0;
+	*last_diff = 0;
+	for (int block = x_start; block < x_end; block += 64){
+		block_size = (x_end - block < 64) ? x_end - block : 64;
+		todo = ordered_flip_mask(&row[block], block_size) | (uint64_t)changed;
+		changed = 0;
+		while (todo != 0){
+			x = block + __builtin_ctzll(todo);
+			todo &= todo - 1;
+			val = row[x];
+			my_current = val & 1;
+			my_new = RULE_NEW_STATE(my_current, val>>2);
+			if (my_new == my_current)
+				continue;
+			diff = my_new - my_current;
+			row[x] = val + diff;  // only the state changes
+			// The cell on the right gets the new prev and nei, the one on the left the new nei
+			if (x + 1 < x_end){
+				row[x + 1] += diff*6;
+				if (x + 1 - block < block_size)
+					todo |= (uint64_t)1 << (x + 1 - block);
+				else
+					changed = 1;
+			}
+			if (x > x_start)
+				row[x - 1] += diff*4;
+			if (x == x_start)
+				*first_diff = diff;
+			if (x == x_end - 1)
+				*last_diff = diff;
+		}
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void speculative_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Ordered evolution with speculative fragments.
+	// In ordered_evolution a row is split only at the line_independent cells, which don't depend on the cell on their left.
+	// Here each central row is split in equal fragments (one for each omp thread), and all the fragments are evolved
+	// in parallel assuming that the last cell of the fragment on their left doesn't change state (the only way
+	// a fragment depends on the previous one). The last fragment also assumes that the first cell of the row doesn't
+	// change (on the torus it's the right neighbour of the last cell, and it's evolved before it).
+	// Then a single thread checks the fragments from left to right: if the assumption of a fragment was wrong
+	// (misspeculation), its cells are restored from a copy of the row and it's evolved again with the right values.
+	// The fragments change only their own cells, so a fragment can be evolved again without undoing the others.
+	// At the end the changes of state are passed to the cells outside the fragments and to the rows above and below.
+	// The results are the same of the serial ordered evolution.
+	//
+	// Central row structure (a single parallel region for the central rows of a generation):
+	// 	omp for:    copy of the fragment, speculative evolution of the fragment
+	// 	omp single: check of the fragments in order, new evolution of the wrong ones, updates across the fragments
+	// 	omp for:    update of nei in the rows above and below
+	//
+	// The fraction of misspeculated fragments is reported at the end (process 0, on stderr).
+	// The MPI communications are the same of ordered_evolution.
+
+	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+	unsigned char *old_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));  // the row before its evolution
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Fragments of the rows: the fragment k has the cells from frag_start[k] to frag_start[k+1]-1
+	int n_fragments = omp_get_max_threads();
+	if (n_fragments > xsize / SPECULATIVE_MIN_FRAGMENT)
+		n_fragments = xsize / SPECULATIVE_MIN_FRAGMENT;
+	if (n_fragments < 1)
+		n_fragments = 1;
+	int *frag_start = (int *)malloc((n_fragments + 1) * sizeof(int));
+	for (int k=0; k<=n_fragments; k++){
+		frag_start[k] = (int)((long int)k * xsize / n_fragments);
+	}
+	char *first_diff = (char *)malloc(n_fragments * sizeof(char));  // change of state of the first cell of each fragment
+	char *last_diff = (char *)malloc(n_fragments * sizeof(char));   // change of state of the last cell of each fragment
+
+	long int fragments = 0;       // fragments evolved
+	long int misspeculated = 0;   // fragments evolved again
+
+	MPI_Request initial[2]; // Handle for the initialization comm.
+	MPI_Request sendlast = MPI_REQUEST_NULL; // Initialized requestS to not get stuck in the wait
+	MPI_Request sendfirst = MPI_REQUEST_NULL;
+	MPI_Request recvbottom;
+
+	// Getting the ghost rows
+	
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &initial[0]);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &initial[1]);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Recv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	// Wait for both routines to complete
+	MPI_Waitall(2, initial, MPI_STATUSES_IGNORE);
+
+	// Initializing the grid to get the right value of prev and nei for all cells 
+	ordered_encode(my_grid, xsize, my_chunk, top_ghost_row, bottom_ghost_row);
+
+	// Sending the bottom row of the last MPI process to begin the gen cycle. The tag is 0
+	if (rank == size-1){
+		MPI_Send(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD);
+	}
+	// Also the top row of each MPI process (except the fist one!) should be sent for the cycle to begin. The tag is 1
+	if (rank != 0){
+		MPI_Send(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD);
+	}
+
+	// Starting the iteration on the generations
+	
+	for (int gen=0; gen<n; gen++) {
+		
+		// The beginning of an MPI cycle is marked by the blocking receive of the upper ghost row. The tag is 0
+		MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+
+		// From the beginning we ask for the bottom ghost row, but we put a wait only on the last line. The tag is 1
+		MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1 , MPI_COMM_WORLD, &recvbottom);
+		
+		// Updating the first line (no parallelization)
+		ordered_first_row(my_grid, top_ghost_row, xsize);
+		
+		// Sending the fist line. The tag is 1
+		MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+
+		// Updating the central lines ( PARALLELIZATION )
+
+		#pragma omp parallel
+		{
+			for (int y = 1; y < my_chunk-1; y++){
+				unsigned char *row = &my_grid[(long int)y*xsize];
+
+				// Speculative evolution of all the fragments
+				#pragma omp for schedule( static )
+				for (int k=0; k<n_fragments; k++){
+					memcpy(&old_row[frag_start[k]], &row[frag_start[k]], frag_start[k+1] - frag_start[k]);
+					speculative_fragment(my_grid, y, xsize, frag_start[k], frag_start[k+1], &first_diff[k], &last_diff[k]);
+				}// implicit barrier
+
+				#pragma omp single
+				{
+					// Checking the fragments from left to right
+					for (int k=0; k<n_fragments; k++){
+						char left = (k > 0) ? last_diff[k-1] : 0;             // change of the cell on the left
+						char wrap = (k == n_fragments-1) ? first_diff[0] : 0;  // change of the first cell of the row
+						fragments++;
+						if (left != 0 || wrap != 0){
+							misspeculated++;
+							memcpy(&row[frag_start[k]], &old_row[frag_start[k]], frag_start[k+1] - frag_start[k]);
+							row[frag_start[k]] += left*6;   // prev and nei of the first cell
+							row[xsize - 1] += wrap*4;        // nei of the last cell of the row
+							speculative_fragment(my_grid, y, xsize, frag_start[k], frag_start[k+1], &first_diff[k], &last_diff[k]);
+						}
+					}
+					// Changes passed backward: the first cell of a fragment changes nei of the cell on its left
+					for (int k=1; k<n_fragments; k++){
+						row[frag_start[k] - 1] += first_diff[k]*4;
+					}
+					// The last cell of the row changes nei of the first one and prev of the first cell of the next row
+					row[0] += last_diff[n_fragments-1]*4;
+					row[xsize] += last_diff[n_fragments-1]*2;
+				}// implicit barrier
+
+				// Updating nei in the rows above and below (the column x gets the changes of x-1, x, x+1)
+				#pragma omp for schedule( static )
+				for (int k=0; k<n_fragments; k++){
+					int x_left, x_right;
+					char d;
+					for (int x=frag_start[k]; x<frag_start[k+1]; x++){
+						x_left = (x == 0) ? xsize-1 : x-1;
+						x_right = (x == xsize-1) ? 0 : x+1;
+						d = ((row[x_left] & 1) - (old_row[x_left] & 1)) + ((row[x] & 1) - (old_row[x] & 1)) + ((row[x_right] & 1) - (old_row[x_right] & 1));
+						if (d != 0){
+							row[x - xsize] += d*4;
+							row[x + xsize] += d*4;
+						}
+					}
+				}// implicit barrier
+			}// End of iteration on central line
+		}// end omp parallel
+		
+		// Waiting for the bottom ghost row to arrive
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+		
+		// Updating the last line (no parallelization)
+		ordered_last_row(my_grid, bottom_ghost_row, xsize, my_chunk);
+		
+		// The MPI cycle ends by sending the last row, without it the bottom neighbour. The tag is 0
+		MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			//writing the temporary grid
+			for (int i=0; i<xsize*my_chunk; i++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[i] = my_grid[i] & 1;
+			}
+
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+
+			if (rank == size-1){ // The last process will write the snapshot		
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", gen);
+			}
+		}
+		
+	} // End cycle on gen
+	
+	// Deallocating the handles
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+	// Receiving the last messages to end the communication
+	if (rank == 0){
+		MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	if (rank != size-1){
+		MPI_Recv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+
+	// Reporting the misspeculation rate of all the processes
+	long int local_counts[2] = {fragments, misspeculated};
+	long int counts[2];
+	MPI_Reduce(local_counts, counts, 2, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0){
+		fprintf(stderr, "Speculative fragments: %ld, misspeculated: %ld (%.2f%%)\n", counts[0], counts[1],
+		        (counts[0] > 0) ? 100.0 * counts[1] / counts[0] : 0.0);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	if(s == n){
+		//writing the temporary grid
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = my_grid[i] & 1;
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+		if (rank == size-1){ // The last process will write the snapshot
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", n-1);
+		}
+	}
+
+	if (top_ghost_row != NULL)
+		free(top_ghost_row);
+	if (bottom_ghost_row != NULL)
+		free(bottom_ghost_row);
+	if (snap_grid != NULL)
+		free(snap_grid);
+	free(old_row);
+	free(frag_start);
+	free(first_diff);
+	free(last_diff);
+
+	return;
+}
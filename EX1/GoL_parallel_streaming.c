@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_halo.h"
+#include <immintrin.h>  // _mm_sfence
+#include <omp.h>
+
+void streaming_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s) {
+
+	// Static evolution with two grids instead of the two bits of static_evolution.
+	// The states of a generation are in the source grid (one state per char, 0 or 1), which is only read,
+	// and the new states are written in the destination grid, which is only written, then the two grids are
+	// swapped (only the pointers). The in-place update reads and writes every char, and the cache line of each
+	// store must be read first (write-allocate). Here the destination is written with non-temporal stores
+	// (see static_stream_row), which skip the read and the cache. So when the grid is much larger than the
+	// last level cache the traffic to memory is one read and one write per cell instead of two and two.
+	// Only the three rows around the one being written are read, and each row is read by three consecutive
+	// rows, so this window of rows stays in the cache while moving down the band of a thread.
+	//
+	// Since the states are plain 0 and 1, the snapshots are gathered directly from the source grid
+	// (with a datatype that skips the ghost columns and the padding), without extracting the current bit.
+	// The ghost rows are received directly in the destination grid, which is the source grid of the following generation.
+	// The exchange is done by the backend chosen with select_halo_backend (see GoL_parallel_halo.c).
+	//
+	// MPI communications stucture:
+	//
+	// halo_exchange_finish (source grid)
+	// 	First row
+	//	Last row
+	// halo_exchange_start (destination grid)
+	// 	Central rows
+	// Writing snapshots (from the source grid)
+	// Swapping the grids
+
+	halo_grid grids[2];
+	halo_grid *source = &grids[0];
+	halo_grid *destination = &grids[1];
+	halo_grid *swap;
+	halo_grid_init(&grids[0], xsize, my_chunk);
+	halo_grid_init(&grids[1], xsize, my_chunk);
+	halo_grid_load(source, my_grid);
+
+	// The rows of the process in a halo grid (the same for both grids, they have the same stride)
+	MPI_Datatype rows_type;
+	MPI_Type_vector(my_chunk, xsize, source->stride, MPI_UNSIGNED_CHAR, &rows_type);
+	MPI_Type_commit(&rows_type);
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// Sharing the ghost rows to start the generations
+	halo_exchange exchange;
+	halo_exchange_init(&exchange, grids, 2, top_neighbour, bottom_neighbour, num_cells[top_neighbour] / xsize);
+	halo_exchange_start(&exchange, 0);
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// Waiting for the ghost rows of the source grid (and for the sends of its rows: they must be
+		// completed before the grid becomes the destination again)
+		halo_exchange_finish(&exchange);
+
+		// Evolution of the first row
+		static_stream_row(halo_row(source, -1), halo_row(source, 0), halo_row(source, 1), halo_row(destination, 0), xsize);
+
+		// Evolution of the last row (if it's not also the first one)
+		if (my_chunk > 1){
+			static_stream_row(halo_row(source, my_chunk - 2), halo_row(source, my_chunk - 1), halo_row(source, my_chunk), halo_row(destination, my_chunk - 1), xsize);
+		}
+		// The non-temporal stores must be completed before MPI reads the rows
+		_mm_sfence();
+
+		// Sending the first and the last row, receiving the ghost rows (in the grid of the next generation)
+		halo_exchange_start(&exchange, (gen + 1) % 2);
+
+		// Parallel evolution of the central rows. Each thread takes a contiguous band of rows, so the window
+		// of three rows moves along the band. Each thread completes its non-temporal stores before the barrier.
+		#pragma omp parallel
+		{
+			#pragma omp for schedule( static ) nowait
+			for(int y=1; y<my_chunk-1; y++){
+				static_stream_row(halo_row(source, y-1), halo_row(source, y), halo_row(source, y+1), halo_row(destination, y), xsize);
+			}
+			_mm_sfence();
+		}// end omp parallel
+
+		// Writing the snapshot file (the state of this generation is in the source grid)
+		if((gen % s == 0) && (s != n)){
+			MPI_Gatherv((void*)halo_row(source, 0), 1, rows_type, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+		swap = source;
+		source = destination;
+		destination = swap;
+
+	} // End cycle on gen
+
+	// Completing the last exchange and reporting the time of the exchanges
+	halo_exchange_free(&exchange);
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file (like in static_evolution, the state of the last generation, now in the destination grid)
+	if(s == n){
+		MPI_Gatherv((void*)halo_row(destination, 0), 1, rows_type, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	// The process keeps its rows in my_grid
+	halo_grid_store(source, my_grid);
+	MPI_Type_free(&rows_type);
+	halo_grid_free(&grids[0]);
+	halo_grid_free(&grids[1]);
+
+	return;
+}
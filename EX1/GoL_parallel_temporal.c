@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include "GoL_parallel_grid.h"
+#include "GoL_parallel_temporal.h"
+#include <omp.h>
+
+// Size of the band of rows of a tile: a band and the rows around it must stay in L2 while they are advanced
+// by several generations (512 KB fits in the L2 of both THIN and EPYC)
+#define TEMPORAL_BAND_BYTES (512 * 1024)
+
+static void evolve_rows(halo_grid *g, int y_start, int y_end, char current, char next){
+
+	// Evolves the rows from y_start to y_end-1 (ghost rows included) by one generation, on a single thread
+
+	for (int y=y_start; y<y_end; y++){
+		static_evolve_padded_row(halo_row(g, y-1), halo_row(g, y), halo_row(g, y+1), g->xsize, current, next);
+		halo_fill_columns(halo_row(g, y), g->xsize);
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void temporal_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int depth) {
+
+	// Static evolution with temporal tiling. Like in deep_halo_static_evolution each process keeps H ghost rows
+	// on each side and exchanges them once every H generations (a wave), but in a wave the rows are not swept
+	// once per generation: they are split in bands (tiles) of rows small enough to stay in L2, and each tile is
+	// advanced by all the generations of the wave before moving to the next one. So the rows are read from memory
+	// once per wave instead of once per generation.
+	//
+	// The tiles are trapezoids in the (row, generation) plane. A tile can't advance the rows on its borders,
+	// since their neighbours in the other tile are still behind, so in the first phase each band [a, b) advances
+	// the rows from a+t+1 to b-t-2 to the generation t+1 (a trapezoid that shrinks by one row per generation).
+	// After this phase the rows between two bands form a valley, the rows at distance d from the border are at
+	// generation d, and in the second phase each valley is filled with an inverted trapezoid: at the step t the
+	// rows at generation t (the 2(t+1) rows around the border) are advanced to t+1.
+	// The encoding is the same of static_evolution: a row at generation t+1 still has the state of generation t
+	// in the other bit, and in both phases the rows around a row are at the same generation or one ahead,
+	// so they can always be read with the bit "current" of the generation of the row.
+	// The bands (and the valleys) are independent and are shared between the omp threads.
+	// The ghost rows are the first and last band: their outer rows are never completed (like in the deep halo,
+	// the region with a valid state shrinks), but after H generations the rows of the process are all valid.
+	//
+	// Wave structure:
+	//
+	// Writing snapshots (only at the beginning of a wave, so a wave stops at the generations of the snapshots)
+	// isend/irecv(H first rows, H last rows), Wait
+	// 	Phase 1: trapezoids of the bands
+	// 	Phase 2: inverted trapezoids between the bands
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	// The H rows sent by a process must be its own rows, so H <= smallest chunk
+	int H = depth;
+	if (H > xsize / size)
+		H = xsize / size;
+	if (H < 1)
+		H = 1;
+	if (H != depth && rank == 0)
+		fprintf(stderr, "Depth of the tiles reduced from %d to %d (the rows of a process must be at least the depth)\n", depth, H);
+
+	halo_grid halo;
+	halo_grid_init_deep(&halo, xsize, my_chunk, H);
+	halo_grid_load(&halo, my_grid);
+	unsigned char *snap_grid = (unsigned char*)malloc((long int)xsize*my_chunk*sizeof(unsigned char));
+
+	// Height of the bands: as many rows as fit in TEMPORAL_BAND_BYTES, but at least 2H+1
+	// (the valleys around two borders must be separated by a row that reaches the last generation of the wave)
+	int band = TEMPORAL_BAND_BYTES / halo.stride;
+	if (band < 2 * H + 1)
+		band = 2 * H + 1;
+
+	// Alternating positions of the current and next states of the system
+	char current = 1;
+	char next = 2;
+	int steps;      // generations of the wave (H, or less before a snapshot and at the end of the evolution)
+	int y_first, y_last;  // rows of the wave, ghost rows included (from y_first to y_last-1)
+	int n_bands;
+	int count;      // chars sent for the rows of the halo (the rows are contiguous, with their ghost columns)
+
+	MPI_Request requests[4]; // Handles for the non blocking comm.
+
+	// Starting the iteration on the waves of generations
+	for (int gen=0; gen<n; gen+=steps) {
+
+		// Writing the snapshot file (the state of the generation gen, in the bit "current")
+		current = gen % 2 + 1;
+		if((gen % s == 0) && (s != n)){
+			//writing the temporary grid
+			for (int y=0; y<my_chunk; y++){
+				for (int x=0; x<xsize; x++){
+					//snap_grid will have the value of the grid at the current state
+					snap_grid[(long int)y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+				}
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+		steps = (n - gen < H) ? (n - gen) : H;
+		if ((s != n) && (s - gen % s < steps))
+			steps = s - gen % s;
+
+		// Sharing the ghost rows of the wave (only "steps" rows are needed)
+		count = (steps - 1) * halo.stride + xsize + 2;
+		// Each process sends its top rows to its top neighbour. The tag is 1
+		MPI_Isend(halo_row(&halo, 0) - 1, count, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &requests[0]);
+		// Each process sends its bottom rows to its bottom neighbour. The tag is 0
+		MPI_Isend(halo_row(&halo, my_chunk - steps) - 1, count, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &requests[1]);
+		// Each process receives its bottom ghost rows from its bottom neighbour
+		MPI_Irecv(halo_row(&halo, my_chunk) - 1, count, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &requests[2]);
+		// Each process receives its top ghost rows from its top neighbour
+		MPI_Irecv(halo_row(&halo, -steps) - 1, count, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &requests[3]);
+		MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+
+		y_first = -steps;
+		y_last = my_chunk + steps;
+		// The rows left after the last whole band are added to it
+		n_bands = (y_last - y_first) / band;
+		if (n_bands < 1)
+			n_bands = 1;
+
+		#pragma omp parallel private(current, next)
+		{
+			// Phase 1: each band [a, b) advances the rows from a+t+1 to b-t-2 to the generation gen+t+1
+			#pragma omp for schedule( dynamic, 1 )
+			for (int i=0; i<n_bands; i++){
+				int a = y_first + i * band;
+				int b = (i == n_bands - 1) ? y_last : a + band;
+				for (int t=0; t<steps; t++){
+					current = (gen + t) % 2 + 1;
+					next = 2 - (gen + t) % 2;
+					evolve_rows(&halo, a + t + 1, b - t - 1, current, next);
+				}
+			}// implicit barrier
+
+			// Phase 2: the valley around each border between two bands is filled up to the generation gen+steps
+			#pragma omp for schedule( dynamic, 1 )
+			for (int i=1; i<n_bands; i++){
+				int border = y_first + i * band;  // first row of the band below
+				for (int t=0; t<steps; t++){
+					current = (gen + t) % 2 + 1;
+					next = 2 - (gen + t) % 2;
+					evolve_rows(&halo, border - t - 1, border + t + 1, current, next);
+				}
+			}
+		}// end omp parallel
+
+	} // End cycle on gen
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	// Writing the snapshot file (like in static_evolution, the state of the generation n-1, still in the other bit)
+	if(s == n){
+		current = (n - 1) % 2 + 1;
+		//writing the temporary grid
+		for (int y=0; y<my_chunk; y++){
+			for (int x=0; x<xsize; x++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[(long int)y*xsize + x] = ((halo_row(&halo, y)[x] & current) == current);
+			}
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	// The process keeps its rows in my_grid
+	halo_grid_store(&halo, my_grid);
+	halo_grid_free(&halo);
+
+	return;
+}
@@ -0,0 +1,785 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "GoL_parallel_init_evol.h"
+#include "GoL_parallel_read_write.h"
+#include "GoL_kernels.h"
+#include <omp.h>
+
+// The grid of each process is divided in tiles of tile x tile cells, and for each tile a flag (moved) records if some of
+// its cells changed in the last generation. A tile whose neighbourhood (the tile and the 8 tiles around it) didn't change
+// can be skipped, since the rule would give the same result. The columns of tiles wrap like the cells (torus), while
+// above the first row and below the last row of tiles there are the ghost rows.
+
+static char tile_is_active(char *moved, int ty, int tx, int n_ty, int n_tx, char top_moved, char bottom_moved){
+
+	// Returns 1 if the tile (ty, tx) or one of its neighbours changed.
+	// top_moved and bottom_moved are the flags of the ghost rows (used by the first and last row of tiles)
+
+	int yy, xx;
+	for (int dy=-1; dy<=1; dy++){
+		yy = ty + dy;
+		if (yy < 0){
+			if (top_moved)
+				return 1;
+			continue;
+		}
+		if (yy >= n_ty){
+			if (bottom_moved)
+				return 1;
+			continue;
+		}
+		for (int dx=-1; dx<=1; dx++){
+			xx = (tx + dx + n_tx) % n_tx;
+			if (moved[yy*n_tx + xx])
+				return 1;
+		}
+	}
+	return 0;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void tile_activity(char *moved, char *active, int ty_start, int ty_end, int n_ty, int n_tx, char top_moved, char bottom_moved){
+
+	// Computes the flag active of the tiles in the rows of tiles from ty_start to ty_end-1
+	for (int ty=ty_start; ty<ty_end; ty++){
+		for (int tx=0; tx<n_tx; tx++){
+			active[ty*n_tx + tx] = tile_is_active(moved, ty, tx, n_ty, n_tx, top_moved, bottom_moved);
+		}
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void static_evolve_active_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, char *active, char *moved,
+                                     unsigned char *old_row, int xsize, int tile, int n_tx, char current, char next){
+
+	// Evolves the cells of a row that are in active tiles (encoding of static_evolution). The consecutive active tiles
+	// are evolved together with a single call of the kernel. For each tile, moved is set if the new state (bit next)
+	// of some cell is different from the state of two generations before (the value of the bit next before the update,
+	// copied in old_row).
+	// active and moved are the flags of the row of tiles, old_row is a buffer of xsize cells.
+
+	int tx = 0;
+	int tx_end, x_start, x_end;
+	unsigned char changes;
+
+	while (tx < n_tx){
+		if (!active[tx]){
+			tx++;
+			continue;
+		}
+		// Finding the end of the active tiles
+		tx_end = tx;
+		while (tx_end < n_tx && active[tx_end])
+			tx_end++;
+
+		x_start = tx * tile;
+		x_end = (tx_end * tile < xsize) ? tx_end * tile : xsize;
+		memcpy(&old_row[x_start], &my_row[x_start], x_end - x_start);
+		static_evolve_segment(up_row, my_row, down_row, x_start, x_end, xsize, current, next);
+
+		for (; tx<tx_end; tx++){
+			x_start = tx * tile;
+			x_end = (x_start + tile < xsize) ? x_start + tile : xsize;
+			changes = 0;
+			for (int x=x_start; x<x_end; x++){
+				changes |= old_row[x] ^ my_row[x];
+			}
+			moved[tx] |= (changes != 0);
+		}
+	}
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void tile_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int tile) {
+
+	// Static evolution that skips the quiescent tiles.
+	// With the encoding of static_evolution, at generation gen the bit next still holds the state of gen-1.
+	// If in the neighbourhood of a tile the state of gen is equal to the state of gen-2 (the tiles didn't move
+	// in the previous generation), then the state of gen+1 is equal to the state of gen-1, and it's already in the
+	// bit next. So the tiles with still lifes and period-2 oscillators (blinkers) can be skipped without writing anything.
+	// The flag moved of a tile is set if the new state is different from the state of two generations before.
+	// Each omp thread works on a whole row of tiles, so that the flags of a tile are written by a single thread.
+	//
+	// The ghost rows are exchanged only when they changed: if the first (last) row didn't move, the message sent
+	// to the neighbour would be equal to the previous one, so an empty message is sent and the neighbour keeps
+	// its ghost row. The size of the message received tells if the ghost row moved.
+	//
+	// MPI communications stucture (like static_evolution):
+	//
+	// Wait(sendfirst, recvtop)
+	// 	First row (active tiles)
+	// isend/irecv(sendfirst, recvtop)  (empty message if the row didn't move)
+	// Wait(sendlast, recvbottom)
+	//	Last row (active tiles)
+	// isend/irecv(sendlast, recvbottom)  (empty message if the row didn't move)
+	// 	Central rows (active tiles)
+	// Writing snapshots
+
+	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+	unsigned char *old_rows = (unsigned char *)malloc((long int)omp_get_max_threads() * xsize * sizeof(unsigned char)); // a row for each thread
+
+	// Alternating positions of the current and next states of the system
+	char current = 1;
+	char next = 2;
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	if (tile > xsize)
+		tile = xsize;
+	int n_ty = (my_chunk + tile - 1) / tile;  // number of rows of tiles
+	int n_tx = (xsize + tile - 1) / tile;     // number of columns of tiles
+	int last_ty = n_ty - 1;
+
+	char *moved = (char *)malloc(n_ty * n_tx * sizeof(char));      // flags of the previous generation
+	char *new_moved = (char *)malloc(n_ty * n_tx * sizeof(char));  // flags of this generation
+	char *active = (char *)malloc(n_ty * n_tx * sizeof(char));     // tiles to evolve in this generation
+	char *first_moved = (char *)malloc(n_tx * sizeof(char));       // flags of the first row
+	char *last_moved = (char *)malloc(n_tx * sizeof(char));        // flags of the last row
+	char *swap;
+	// At the beginning all the tiles are active (the bit next doesn't hold a previous state yet)
+	memset(moved, 1, n_ty * n_tx * sizeof(char));
+	char top_moved, bottom_moved;  // flags of the ghost rows
+	char row_moved;
+	int count;
+	long int skipped = 0;  // number of tiles skipped
+
+	MPI_Request sendfirst, sendlast, recvtop, recvbottom; // Handles for the non blocking comm.
+	MPI_Status status;
+
+	// Sharing the ghost rows to start the generations
+
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0,MPI_COMM_WORLD, &recvtop);
+
+	// Starting the iteration on the generations
+	for (int gen=0; gen<n; gen++) {
+
+		// Alternating positions of the current and next states of the system
+		current = gen % 2 + 1;
+		next = 2 - gen % 2;
+
+		// waiting for the operations on the first row
+		MPI_Wait(&recvtop, &status);
+		MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &count);
+		top_moved = (gen == 0) || (count > 0);
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+
+		// If the process has a single row, also the bottom ghost row is needed for the first row
+		if (my_chunk == 1){
+			MPI_Wait(&recvbottom, &status);
+			MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &count);
+			bottom_moved = (gen == 0) || (count > 0);
+		}
+
+		// Finding the active tiles. The flag of the bottom ghost row is not known yet, so the last row of tiles
+		// is considered active near the bottom ghost row, and it will be checked again when the ghost row arrives
+		tile_activity(moved, active, 0, n_ty, n_ty, n_tx, top_moved, (my_chunk == 1) ? bottom_moved : 1);
+
+		// Evolution of the first row
+		memset(first_moved, 0, n_tx * sizeof(char));
+		static_evolve_active_row(top_ghost_row, &my_grid[0], (my_chunk == 1) ? bottom_ghost_row : &my_grid[xsize],
+		                         active, first_moved, old_rows, xsize, tile, n_tx, current, next);
+		row_moved = 0;
+		for (int tx=0; tx<n_tx; tx++){
+			row_moved |= first_moved[tx];
+		}
+
+		// Sending the fist line (empty if it didn't move). The tag is 1
+		MPI_Isend(&my_grid[0], row_moved ? xsize : 0, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+		// Receving the new top_ghost_row. The tag is 0
+		MPI_Irecv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, &recvtop);
+
+		// Waiting for the operations on the last row
+		if (my_chunk > 1){
+			MPI_Wait(&recvbottom, &status);
+			MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &count);
+			bottom_moved = (gen == 0) || (count > 0);
+			tile_activity(moved, active, last_ty, n_ty, n_ty, n_tx, top_moved, bottom_moved);
+		}
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+		// Evolution of the last row
+		if (my_chunk > 1){
+			for (int tx=0; tx<n_tx; tx++){
+				last_moved[tx] = 0;
+			}
+			static_evolve_active_row(&my_grid[(my_chunk - 2) * xsize], &my_grid[(my_chunk - 1) * xsize], bottom_ghost_row,
+			                         &active[last_ty * n_tx], last_moved, old_rows, xsize, tile, n_tx, current, next);
+			row_moved = 0;
+			for (int tx=0; tx<n_tx; tx++){
+				row_moved |= last_moved[tx];
+			}
+		}else{
+			memcpy(last_moved, first_moved, n_tx * sizeof(char));
+		}
+
+		// Sending the last row (empty if it didn't move). The tag is 0
+		MPI_Isend(&my_grid[(my_chunk - 1) * xsize], row_moved ? xsize : 0, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+		// Receving the new bottom_ghost_row. The tag is 1
+		MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, &recvbottom);
+
+		// Parallel evolution of the central rows of the active tiles (a row of tiles for each thread)
+		#pragma omp parallel for schedule( dynamic, 1 ) reduction(+:skipped)
+		for (int ty=0; ty<n_ty; ty++){
+			unsigned char *old_row = &old_rows[(long int)omp_get_thread_num() * xsize];
+			int y_start = (ty*tile > 1) ? ty*tile : 1;
+			int y_end = ((ty+1)*tile < my_chunk-1) ? (ty+1)*tile : my_chunk-1;
+
+			// Adding the changes of the first and last row
+			for (int tx=0; tx<n_tx; tx++){
+				new_moved[ty*n_tx + tx] = ((ty == 0) && first_moved[tx]) || ((ty == last_ty) && last_moved[tx]);
+				skipped += !active[ty*n_tx + tx];
+			}
+			for (int y=y_start; y<y_end; y++){
+				static_evolve_active_row(&my_grid[(y-1)*xsize], &my_grid[y*xsize], &my_grid[(y+1)*xsize],
+				                         &active[ty*n_tx], &new_moved[ty*n_tx], old_row, xsize, tile, n_tx, current, next);
+			}
+		}// end omp parallel
+
+		// At the first generation the bit next didn't hold a state, so all the tiles must stay active
+		if (gen == 0)
+			memset(new_moved, 1, n_ty * n_tx * sizeof(char));
+
+		swap = moved;
+		moved = new_moved;
+		new_moved = swap;
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			//writing the temporary grid
+			for (int i=0; i<xsize*my_chunk; i++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[i] = ((my_grid[i] & current) == current);
+			}
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+			if (rank == 0){
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", gen);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+
+	} // End cycle on gen
+
+	// Deallocating all the handles
+	MPI_Wait(&recvtop, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+	MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+	// Reporting the fraction of tiles skipped (on stderr, to keep the timing output clean)
+	long int local_tiles[2] = {skipped, (long int)n * n_ty * n_tx};
+	long int total_tiles[2];
+	MPI_Reduce(local_tiles, total_tiles, 2, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0 && total_tiles[1] > 0){
+		fprintf(stderr, "Tiles skipped: %ld of %ld (%.1f%%)\n", total_tiles[0], total_tiles[1], 100.0 * total_tiles[0] / total_tiles[1]);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	if (top_ghost_row != NULL)
+		free(top_ghost_row);
+	if (bottom_ghost_row != NULL)
+		free(bottom_ghost_row);
+	if (old_rows != NULL)
+		free(old_rows);
+	if (moved != NULL)
+		free(moved);
+	if (new_moved != NULL)
+		free(new_moved);
+	if (active != NULL)
+		free(active);
+	if (first_moved != NULL)
+		free(first_moved);
+	if (last_moved != NULL)
+		free(last_moved);
+
+	// Writing the snapshot file (like in static_evolution)
+	if(s == n){
+		//writing the temporary grid
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = ((my_grid[i] & current) == current);
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+		if (rank == 0){
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_static/snapshot", n);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	return;
+}
+
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static char ordered_tile_is_active(char *moved, char *new_moved, int ty, int tx, int n_ty, int n_tx){
+
+	// Returns 1 if the tile (ty, tx) or one of its neighbours changed in the previous generation (moved)
+	// or in this generation before now (new_moved, that can be written by other threads).
+
+	int yy, xx;
+	char flag;
+	for (int dy=-1; dy<=1; dy++){
+		yy = ty + dy;
+		if (yy < 0 || yy >= n_ty)
+			continue;
+		for (int dx=-1; dx<=1; dx++){
+			xx = (tx + dx + n_tx) % n_tx;
+			#pragma omp atomic read
+			flag = new_moved[yy*n_tx + xx];
+			if (flag || moved[yy*n_tx + xx])
+				return 1;
+		}
+	}
+	return 0;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+static void set_moved(char *new_moved, int t){
+	// Marks the tile t as changed in this generation
+	#pragma omp atomic write
+	new_moved[t] = 1;
+}
+
+// ######################################################################################################################################
+
+// ######################################################################################################################################
+
+void tile_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int tile) {
+
+	// Ordered evolution that skips the quiescent tiles (see ordered_evolution for the algorithm).
+	// In the encoding of ordered_evolution each cell stores its number of neighbours, that is updated as soon
+	// as a neighbour changes. So if the value of a cell didn't change since its last update (and the update
+	// didn't change its state) the update would give again the same state.
+	// A tile of the central rows can be skipped if neither the tile nor its neighbours changed in the previous
+	// generation (after the tile was updated) or in this generation (before the tile is updated).
+	// The first and the last row recompute the neighbours from the ghost rows, so they are always updated.
+	//
+	// Since only the state of the cells in the ghost rows is used, the first and last rows are sent only if the state
+	// of some cell changed, otherwise an empty message is sent and the neighbour keeps its ghost row.
+	// The messages are still needed to keep the order of the processes.
+	//
+	// MPI communications stucture (like ordered_evolution):
+	//
+	// Recv(top_ghost_row) (blocking)
+	// IRecv(bottom_ghost_row) (handle: recvbottom)
+	// 	First row
+	// ISend(first row) (handle: sendfirst, empty if the row didn't change)
+	//	Central rows (active tiles)
+	// Wait(recvbottom)
+	// Wait(sendlast) (deallocating handle)
+	// 	Last row
+	// Wait(sendfirst) (deallocating handle)
+	// Isend(last row) (handle: sendlast, empty if the row didn't change)
+
+	unsigned char *top_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+	unsigned char *bottom_ghost_row = (unsigned char *)malloc(xsize * sizeof(unsigned char));
+
+	unsigned char *snap_grid = (unsigned char*)malloc(xsize*my_chunk*sizeof(unsigned char));
+
+	char val;
+	char diff;
+	char prev; // Will be 1 if the previous cell is alive and 0 otherwise
+	char nei; // Number of alive neighbours
+	char my_current, my_new; // current/new state of the cell. It can be either 1 or 0
+	char active; // 1 if the tile of the cell must be updated
+	char row_moved; // 1 if some cell of the first/last row changed
+	int stride = 640;  // The minimum size of the fragment of the row in which a thread will work
+
+	//This will help in the computation of neighbuouring cells
+	int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
+	int right_move;   // right_move = +1 - (xsize if x == xsize-1). This will make it go down a row if on the right border
+	int up_move = -xsize;      // This will make it go up a row (There's no way of looping back to the top row because we use ghost rows)
+	int down_move = xsize;     // This will make it go down a row
+	int pos;          // pos = y*xsize + x.   Current position
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank); //get the rank of the current process
+	MPI_Comm_size(MPI_COMM_WORLD, &size); //get the total number of processes
+
+	int top_neighbour = (rank - 1 + size) % size; // Rank of the MPI process above
+	int bottom_neighbour = (rank + 1) % size; // Rank of the MPI process below
+
+	int* l_ind_pos = (int *)malloc(((xsize/stride)+1) * sizeof(int));  // positions of line_independent cells
+	int* l_ind_dist = (int *)malloc(((xsize/stride)+1) * sizeof(int)); // distance from the nth l_ind cell to the following l_ind cell (including the first cell)
+	int count; // number of l_ind cells found
+
+	if (tile > xsize)
+		tile = xsize;
+	int n_ty = (my_chunk + tile - 1) / tile;  // number of rows of tiles
+	int n_tx = (xsize + tile - 1) / tile;     // number of columns of tiles
+
+	char *moved = (char *)malloc(n_ty * n_tx * sizeof(char));      // flags of the previous generation
+	char *new_moved = (char *)malloc(n_ty * n_tx * sizeof(char));  // flags of this generation
+	char *swap;
+	// At the beginning all the tiles are active
+	memset(moved, 1, n_ty * n_tx * sizeof(char));
+	long int skipped = 0;  // number of cell updates skipped
+
+	MPI_Request initial[2]; // Handle for the initialization comm.
+	MPI_Request sendlast = MPI_REQUEST_NULL; // Initialized requestS to not get stuck in the wait
+	MPI_Request sendfirst = MPI_REQUEST_NULL;
+	MPI_Request recvbottom;
+
+	// Getting the ghost rows
+
+	// Each process sends its top row to its top neighbour
+	MPI_Isend(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &initial[0]);
+	// Each process sends its bottom row to its bottom neighbour
+	MPI_Isend(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &initial[1]);
+	// Each process receives its bottom ghost row from its bottom neighbour
+	MPI_Recv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	// Each process receives its top ghost row from its top neighbour
+	MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	// Wait for both routines to complete
+	MPI_Waitall(2, initial, MPI_STATUSES_IGNORE);
+
+	// Initializing the grid to get the right value of prev and nei for all cells
+
+	for (int y = 0; y<my_chunk; y++){
+		for (int x = 0; x<xsize; x++){
+
+			pos = y*xsize + x;   //Current position
+			nei = 0;
+			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
+			right_move = +1 - (xsize * (x == xsize-1)); //This will make it go down a row if on the right border
+
+			//computing the number of neighbours
+			if (y==0){  // Using the top_ghost_row
+				nei+=top_ghost_row[x + left_move] & 1; //  & 1 will give the value of the first bit
+				nei+=top_ghost_row[x] & 1;
+				nei+=top_ghost_row[x + right_move] & 1;
+			}else{
+				nei+=my_grid[pos - xsize + left_move] & 1;
+				nei+=my_grid[pos - xsize] & 1;
+				nei+=my_grid[pos - xsize + right_move] & 1;
+			}
+			nei+=my_grid[pos + left_move] & 1;
+			nei+=my_grid[pos + right_move] & 1;
+			if (y==my_chunk-1){  // Using the bottom_ghost_row
+				nei+=bottom_ghost_row[x + left_move] & 1;
+				nei+=bottom_ghost_row[x] & 1;
+				nei+=bottom_ghost_row[x + right_move] & 1;
+			}else{
+				nei+=my_grid[pos + xsize + left_move] & 1;
+				nei+=my_grid[pos + xsize] & 1;
+				nei+=my_grid[pos + xsize + right_move] & 1;
+			}
+			//computing prev
+			if (pos!=0){
+				prev = my_grid[pos -1] & 1;
+			}else{
+				prev = 0;
+			}
+			// the value of each cell will encode its state, the previous cell state and the live neighbours
+			my_grid[pos] = (nei*4) + (prev*2) + (my_grid[pos] & 1);
+		}
+	} // The grid is initialized with the right encoding
+
+	// Sending the bottom row of the last MPI process to begin the gen cycle. The tag is 0
+	if (rank == size-1){
+		MPI_Send(&my_grid[(my_chunk - 1) * xsize], xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD);
+	}
+	// Also the top row of each MPI process (except the fist one!) should be sent for the cycle to begin. The tag is 1
+	if (rank != 0){
+		MPI_Send(&my_grid[0], xsize, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD);
+	}
+
+	// Starting the iteration on the generations
+
+	for (int gen=0; gen<n; gen++) {
+
+		memset(new_moved, 0, n_ty * n_tx * sizeof(char));
+
+		// The beginning of an MPI cycle is marked by the blocking receive of the upper ghost row. The tag is 0
+		// (an empty message leaves the ghost row as it is)
+		MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+		// Deallocate sendfirst
+		MPI_Wait(&sendfirst, MPI_STATUS_IGNORE);
+
+		// From the beginning we ask for the bottom ghost row, but we put a wait only on the last line. The tag is 1
+		MPI_Irecv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1 , MPI_COMM_WORLD, &recvbottom);
+
+		// Updating the first line (no parallelization)
+
+		row_moved = 0;
+		for (int x = 0; x < xsize; x++){
+
+			pos = x;   //Current position
+			nei = 0;
+			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
+			right_move = +1 - (xsize * (x == (xsize-1))); //This will make it go down a row if on the right border
+			// computing the number of neighbours
+			nei+=top_ghost_row[x + left_move] & 1;
+			nei+=top_ghost_row[x] & 1;
+			nei+=top_ghost_row[x + right_move] & 1;
+			nei+=my_grid[pos + left_move] & 1;
+			nei+=my_grid[pos + right_move] & 1;
+			nei+=my_grid[pos + down_move + left_move] & 1;
+			nei+=my_grid[pos + down_move] & 1;
+			nei+=my_grid[pos + down_move + right_move] & 1;
+			// computing prev
+			if (pos!=0){
+				prev = my_grid[pos -1] & 1;
+			}else{
+				prev = 0;
+			}
+			// Evolving the state
+			my_current = my_grid[pos] & 1;
+			my_new = RULE_NEW_STATE(my_current, nei); // Evaluates the new state of the grid
+			diff = my_new - my_current;
+			my_grid[pos] = (nei*4) + (prev*2) + my_new;
+			// Updating the value of prev in the next cell
+			my_grid[pos + 1] += diff*2; // The value of the second bit will increase or decrease by one
+			// Updating the value nei in the other cells
+			my_grid[pos + left_move]              += diff*4;
+			my_grid[pos + down_move + left_move]  += diff*4; // nei is stored starting from the third bit, it will
+			my_grid[pos + down_move]              += diff*4; // increase or decrease by one
+			my_grid[pos + down_move + right_move] += diff*4;
+			if (x == xsize-1){
+				my_grid[pos + right_move]     += diff*4;
+			}
+			if (diff != 0){
+				new_moved[x / tile] = 1;
+				row_moved = 1;
+			}
+
+		}// end of work on the first line
+
+		// Sending the fist line (empty if no cell changed). The tag is 1
+		MPI_Isend(&my_grid[0], row_moved ? xsize : 0, MPI_UNSIGNED_CHAR, top_neighbour, 1, MPI_COMM_WORLD, &sendfirst);
+
+		// Creating the arrays of the line_independent points
+		count =	l_ind(my_grid, 0, xsize, stride, l_ind_pos, l_ind_dist);
+
+		// Updating the central lines ( PARALLELIZATION )
+
+		for (int y = 1; y < my_chunk-1; y++){
+			#pragma omp parallel for schedule( static, 1 ) private(pos, nei, left_move, right_move, prev, my_current, my_new, val, diff, active) reduction(+:skipped)
+			for (int i = 0; i<count; i++){
+				int x_end = l_ind_pos[i] + l_ind_dist[i];  // end of the fragment
+				int x_tile_end;                            // end of the part of the fragment in the same tile
+
+				for (int x = l_ind_pos[i]; x < x_end; x = x_tile_end){
+					x_tile_end = (x / tile + 1) * tile;
+					if (x_tile_end > x_end)
+						x_tile_end = x_end;
+
+					active = ordered_tile_is_active(moved, new_moved, y / tile, x / tile, n_ty, n_tx);
+					if (!active){
+						skipped += x_tile_end - x;
+						continue;
+					}
+
+					for (int xx = x; xx < x_tile_end; xx++){
+						pos = y*xsize + xx;
+						left_move = -1 + (xsize * (xx == 0));
+						right_move = +1 - (xsize * (xx == (xsize-1)));
+						val = my_grid[pos]; // Value of the grid in pos
+						nei = val>>2; // The number of neighbour is stored starting from the third bit on the char
+						prev = val & 2; // The value of the previous cell is stored in the second bit. This is prev*2
+						my_current = val & 1;
+						// The first element of a fragment is a l_ind point: the change of the cell on its left
+						// doesn't change its new state, so it's evolved with the value it has now as the others
+						my_new = RULE_NEW_STATE(my_current, nei);
+						my_grid[pos] = (nei*4) + prev + my_new; // Updating the cell
+						diff = my_new - my_current;
+						if (diff == 0)
+							continue;  // the near cells don't change
+						set_moved(new_moved, (y / tile) * n_tx + xx / tile);
+						// Updating the value of prev in the next cell
+						my_grid[pos + 1] += diff*2;
+						// Updating the value of nei in the near cells
+						diff *= 4;
+						my_grid[pos + up_move + left_move]    += diff;  // diff now stores 4*(my_new - my_current)
+						my_grid[pos + up_move]                += diff;
+						my_grid[pos + up_move + right_move]   += diff;
+						// The information is passed backward only if this is not the first element of a fragment
+						// (the last element of each fragment is modified at the end of the fragments)
+						my_grid[pos + left_move]              += diff * (i==0 || xx != l_ind_pos[i]);
+						my_grid[pos + right_move]             += diff;
+						my_grid[pos + down_move + left_move]  += diff;
+						my_grid[pos + down_move]              += diff;
+						my_grid[pos + down_move + right_move] += diff;
+					}
+				}// End of work on the fragment
+			}// End of the omp parallel
+
+			// Modifying the value of nei in the last element of each fragment
+
+			for (int i = 0; i<count; i++){
+				pos = y*xsize + l_ind_pos[i] + l_ind_dist[i] - 1;
+				left_move = -1 + (xsize * ((pos%xsize) == 0));
+				right_move = +1 - (xsize * ((pos%xsize) == xsize-1));
+				nei = 0;
+				nei+=my_grid[pos + up_move + left_move] & 1;
+				nei+=my_grid[pos + up_move] & 1;
+				nei+=my_grid[pos + up_move + right_move] & 1;
+				nei+=my_grid[pos + left_move] & 1;
+				nei+=my_grid[pos + right_move] & 1;
+				nei+=my_grid[pos + down_move + left_move] & 1;
+				nei+=my_grid[pos + down_move] & 1;
+				nei+=my_grid[pos + down_move + right_move] & 1;
+				my_grid[pos] = (nei*4) + (my_grid[pos] & 3); // The first two bits stay the same
+			}
+
+			// Creating the next arrays of the line_independent points
+			count =	l_ind(my_grid, y, xsize, stride, l_ind_pos, l_ind_dist);
+
+		}// End of iteration on central line
+
+		// Waiting for the bottom ghost row to arrive
+		MPI_Wait(&recvbottom, MPI_STATUS_IGNORE);
+
+		// Deallocate sendlast
+		MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+		// Updating the last line (no parallelization)
+
+		row_moved = 0;
+		for (int x = 0; x < xsize; x++){
+
+			pos = (my_chunk - 1)*xsize + x;   // Current position
+			nei = 0;
+			left_move = -1 + (xsize * (x == 0)); //This will make it go up a row if on the left border
+			right_move = +1 - (xsize * (x == (xsize-1))); //This will make it go down a row if on the right border
+			// Computing the number of neighbours
+			nei+=my_grid[pos + up_move + left_move] & 1;
+			nei+=my_grid[pos + up_move] & 1;
+			nei+=my_grid[pos + up_move + right_move] & 1;
+			nei+=my_grid[pos + left_move] & 1;
+			nei+=my_grid[pos + right_move] & 1;
+			nei+=bottom_ghost_row[x + left_move] & 1;
+			nei+=bottom_ghost_row[x] & 1;
+			nei+=bottom_ghost_row[x + right_move] & 1;
+			// Computing prev
+			prev = my_grid[pos -1] & 1;
+			// Evolving the state
+			my_current = my_grid[pos] & 1;
+			my_new = RULE_NEW_STATE(my_current, nei);
+			diff = my_new - my_current;
+			my_grid[pos] = (nei*4) + (prev*2) + my_new;
+			// Updating the value nei in the other cells
+			my_grid[pos + left_move]            += diff*4;
+			my_grid[pos + up_move + left_move]  += diff*4;
+			my_grid[pos + up_move]              += diff*4;
+			my_grid[pos + up_move + right_move] += diff*4;
+			if (x == xsize-1){
+				my_grid[pos + right_move]   += diff*4;
+			}
+			if (diff != 0){
+				new_moved[(n_ty - 1) * n_tx + x / tile] = 1;
+				row_moved = 1;
+			}
+
+		}// end of work on the last line
+
+		// The MPI cycle ends by sending the last row (empty if no cell changed). The tag is 0
+		MPI_Isend(&my_grid[(my_chunk - 1) * xsize], row_moved ? xsize : 0, MPI_UNSIGNED_CHAR, bottom_neighbour, 0, MPI_COMM_WORLD, &sendlast);
+
+		swap = moved;
+		moved = new_moved;
+		new_moved = swap;
+
+		// Writing the snapshot file
+		if((gen % s == 0) && (s != n)){
+			//writing the temporary grid
+			for (int i=0; i<xsize*my_chunk; i++){
+				//snap_grid will have the value of the grid at the current state
+				snap_grid[i] = my_grid[i] & 1;
+			}
+
+			MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+
+			if (rank == size-1){ // The last process will write the snapshot
+				write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", gen);
+			}
+		}
+
+	} // End cycle on gen
+
+	// Deallocate sendlast.
+	MPI_Wait(&sendlast, MPI_STATUS_IGNORE);
+
+	// Receiving the last messages to end the communication
+	if (rank == 0){
+		MPI_Recv(top_ghost_row, xsize, MPI_UNSIGNED_CHAR, top_neighbour, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	if (rank != size-1){
+		MPI_Recv(bottom_ghost_row, xsize, MPI_UNSIGNED_CHAR, bottom_neighbour, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+
+	// Reporting the fraction of updates skipped (on stderr, to keep the timing output clean)
+	long int local_cells[2] = {skipped, (long int)n * (my_chunk > 2 ? my_chunk - 2 : 0) * xsize};
+	long int total_cells[2];
+	MPI_Reduce(local_cells, total_cells, 2, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (rank == 0 && total_cells[1] > 0){
+		fprintf(stderr, "Cell updates skipped in the central rows: %ld of %ld (%.1f%%)\n", total_cells[0], total_cells[1], 100.0 * total_cells[0] / total_cells[1]);
+	}
+
+	// Waiting for all processes before ending
+	MPI_Barrier(MPI_COMM_WORLD);
+
+	if (top_ghost_row != NULL)
+		free(top_ghost_row);
+	if (bottom_ghost_row != NULL)
+		free(bottom_ghost_row);
+	if (l_ind_pos != NULL)
+		free(l_ind_pos);
+	if (l_ind_dist != NULL)
+		free(l_ind_dist);
+	if (moved != NULL)
+		free(moved);
+	if (new_moved != NULL)
+		free(new_moved);
+
+	if(s == n){
+		//writing the temporary grid
+		for (int i=0; i<xsize*my_chunk; i++){
+			//snap_grid will have the value of the grid at the current state
+			snap_grid[i] = my_grid[i] & 1;
+		}
+		MPI_Gatherv((void*)snap_grid, num_cells[rank], MPI_UNSIGNED_CHAR, (void*)grid, num_cells, displs, MPI_UNSIGNED_CHAR, size-1, MPI_COMM_WORLD);
+		if (rank == size-1){ // The last process will write the snapshot
+			write_snapshot(grid, 1, xsize, xsize, "./Snapshots/parallel_ordered/snapshot", n-1);
+		}
+	}
+	if (snap_grid != NULL)
+		free(snap_grid);
+
+	return;
+}
@@ -5,7 +5,7 @@
 #include <string.h>
 #include <getopt.h>
 
-#include <immintrin.h>  //vector intrinsic
+#include "GoL_kernels.h"
  
 
  struct timespec ts;
@@ -87,7 +87,7 @@ void read_pgm_image( void **image, int *maxval, int *xsize, int *ysize, const ch
   *image = NULL;
   *xsize = *ysize = *maxval = 0;
   
-  char    MagicN[2];
+  char    MagicN[3];
   char   *line = NULL;
   size_t  k, n = 0;
   
@@ -193,7 +193,7 @@ void ordered_evolution(unsigned char *mygrid, int xsize, int ysize, int n, int s
 	char * fname;
 	fname = (char*) malloc(46);
 	
-	char nei; // number of live neighbours
+	int nei; // number of live neighbours
 	
 	//This will help in the computation of neighbuouring cells
 	long int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
@@ -241,7 +241,7 @@ void ordered_evolution(unsigned char *mygrid, int xsize, int ysize, int n, int s
 				
 				// Rewritten without if jumps
 				my_current = mygrid[pos];
-				mygrid[pos] = (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3)); //The value is 1 only if the cell is born
+				mygrid[pos] = RULE_NEW_STATE(my_current, nei); //The value is 1 only if the cell is born
 															// or if the cell stayed alive	
 			}
 		}// end of iteration on cells
@@ -284,7 +284,7 @@ void static_evolution( char *mygrid, int xsize, int ysize, int n, int s){
 	char current_state;
 	char next_state;
 
-	char nei; // number of live neighbours
+	int nei; // number of live neighbours (an int: gcc -O3 vectorizes the shifts of the rule with a char on 8 bits, losing the rule)
 			
 	//This will help in the computation of neighbuouring cells
 	long int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
@@ -337,7 +337,7 @@ void static_evolution( char *mygrid, int xsize, int ysize, int n, int s){
 				//REWITTEN IN A FASTER WAY (without if jumps):
 				
 				my_current = current_state & mygrid[pos];
-				mygrid[pos] = my_current + next_state * (  (!(my_current) && (nei == 3))  ||  (my_current && (nei == 2 || nei == 3))  );
+				mygrid[pos] = my_current + next_state * RULE_NEW_STATE(my_current, nei);
 				//this is done to preserve the current state and modify the next state (they are located on different bits)
 				//explaination: the "next_state" bit will be one only if the cell is born or nothing happens on a live cell
 				
@@ -516,10 +516,10 @@ void static_evolution2( char *mygrid, int xsize, int ysize, int n, int s){ 	//(I
 			my_row = y*xsize;
 			for(int x=0; x<xsize; x++){
 				state = mygrid[my_row+x];
-				mygrid[my_row+x] = (state == 12) || (state == 13) || (state == 3);
+				mygrid[my_row+x] = RULE_NEW_STATE(state >= 10, state % 10);
 				//Explaination:
 				//The cell is alive is the state is greater than 10, while the last digit represents the number of
-				//neighbours. Hence the state will become 1 iff one of the rules above is true.
+				//neighbours. (With B3/S23 the state becomes 1 iff it's 12, 13 or 3)
 				//Idea from cbrew: https://gist.github.com/cbrew/3710694
 			}
 		}
@@ -551,224 +551,68 @@ void static_evolution2( char *mygrid, int xsize, int ysize, int n, int s){ 	//(I
 // *********************************************************************************************************************************
 
 void static_evolutionVEC( char *mygrid, int xsize, int ysize, int n, int s){
-	//(It passed the Pentadecathlon test)
-	//(Elapsed time: 1.744 sec(with SIMD))
-	// There's a performance improvement over the standard evolution! 
-	//(But the test is not balanced,there have been some performance changes after restarting the pc)
+	// SIMD static evolution in a single pass over the grid.
+	// The previous version copied the grid in a padded grid and then used one SSE2 sweep
+	// for each direction of the neighbours (about 10 passes on the memory for each generation).
+	// Here the encoding of static_evolution is used (the state alternates between bit 1 and bit 2)
+	// and each row is evolved by static_evolve_row, that reads the three rows only once (see GoL_kernels.c).
+	// The rows on the top and on the bottom of the grid are neighbours (torus).
 
 	//variables for the snapshot file
 	char * fname;
-	char * padd_grid; //padded grid for the convolution
+	char * snap_grid;
 	fname = (char*) malloc(34);
-	padd_grid = (char*) malloc((xsize+2)*(ysize+2));
+	snap_grid = (char*) malloc(xsize*ysize);
+
+	// alternating positions of the current and next states of the system
+	char current_state;
+	char next_state;
+
+	long int up_row;       // position of the row above (the last row if y == 0)
+	long int down_row;     // position of the row below (the first row if y == ysize-1)
 
-	char state;
-			
-	//This will help in the computation of neighbuouring cells
-	long int n_cells = xsize*ysize;
-	long int padded_row;
-	long int my_row;
-	long int padded_last_row;
-	long int my_last_row;
-	long int left_move;    // left_move = -1 + (xsize if x == 0). This will make it go up a row if on the left border
-	long int right_move;   // right_move = +1 - (xsize if x == xsize-1). This will make it go down a row if on the right border
-	long int up_move;      // up_move = -xsize + (xsize*ysize if y == 0)
-	long int down_move;    // down_move = xsize - (xsize*ysize if y == ysize-1)
-	long int pos;          // pos = y*xsize + x.   Current position
-	
 	for (int gen=0; gen<n; gen++){
-		
-		
-		//Filling the padded grid
-		
-		//Here the first row of the padded grid is filled
-		my_last_row = n_cells-xsize;  //useful variable
-		padd_grid[0] = mygrid[n_cells-1];		
-		for(int x=0; x<xsize; x++){
-			padd_grid[x+1] = mygrid[my_last_row+x];
-		}		
-		padd_grid[xsize+1] = mygrid[my_last_row];
-		
-		//Here the central rows of the padded grid are filled
-		for(int y=0; y<ysize; y++){
-			padded_row = (y+1)*(xsize+2);  
-			my_row = y*xsize;			//useful variables
-			padd_grid[(y+1)*(xsize+2)] = mygrid[my_row +xsize-1];			
-			for(int x=0; x<xsize; x++){
-				padd_grid[padded_row+x+1] = mygrid[my_row +x];
-			}			
-			padd_grid[padded_row+xsize+1] = mygrid[my_row];			
-		}
-		
-		//Here the final row of the padded grid is filled
-		padded_last_row = (ysize+1)*(xsize+2);		
-		padd_grid[padded_last_row] = mygrid[xsize-1];		
-		for(int x=0; x<xsize; x++){
-			padd_grid[padded_last_row+x+1] = mygrid[x];
-		}		
-		padd_grid[padded_last_row+xsize+1] = mygrid[0];
-		//The padded grid is complete
-		
-		
-		//starting the iteration using SIMD
-		for(int y=0; y<ysize; y++){		//multiplying the initial grid by ten
-			my_row = y*xsize;
-			for(int x=0; x<xsize; x++){
-				mygrid[my_row+x] *=10;
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = y*(xsize+2);	//upper left position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = y*(xsize+2)+1;	//upper position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = y*(xsize+2)+2;	//upper right position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = (y+1)*(xsize+2);	//left position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = (y+1)*(xsize+2)+2;	//right position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = (y+2)*(xsize+2);	//lower left position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
-		for(int y=0; y<ysize; y++){
-			padded_row = (y+2)*(xsize+2)+1;	//lower position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
-		}
+
+		// alternating positions of the current and next states of the system
+		current_state = gen % 2 + 1;
+		next_state = 2 - gen % 2;
+
 		for(int y=0; y<ysize; y++){
-			padded_row = (y+2)*(xsize+2)+2;	//lower right position
-			my_row = y*xsize;
-			// Process elements in blocks of 16 characters using SSE2
-			for (int x=0; x <= xsize-16; x += 16) {
-				__m128i vec1 = _mm_loadu_si128((__m128i*)(mygrid + my_row + x));
-				__m128i vec2 = _mm_loadu_si128((__m128i*)(padd_grid + padded_row + x));
-				vec1 = _mm_add_epi8(vec1, vec2);
-				_mm_storeu_si128((__m128i*)(mygrid + my_row + x), vec1);
-			}
-			// Handle remaining elements (less than a full SIMD block)
-			for (int x=xsize-(xsize%16); x < xsize; x++) {
-				mygrid[my_row+x] += padd_grid[padded_row+x];
-			}
+			up_row = (y - 1 + (ysize * (y == 0))) * (long int)xsize;
+			down_row = (y + 1 - (ysize * (y == ysize-1))) * (long int)xsize;
+			static_evolve_row((unsigned char *)mygrid + up_row, (unsigned char *)mygrid + y*(long int)xsize, (unsigned char *)mygrid + down_row, xsize, current_state, next_state);
 		}
-		for(int y=0; y<ysize; y++){		//evolving mygrid according to neighbours and cell state
-			my_row = y*xsize;
-			for(int x=0; x<xsize; x++){
-				state = mygrid[my_row+x];
-				mygrid[my_row+x] = (state == 12) || (state == 13) || (state == 3);
-				//Explaination:
-				//The cell is alive if the first digit is one, while the last digit represents the number of
-				//neighbours. Hence the state will become 1 iff one of the rules above is true.
-				//Idea from cbrew: https://gist.github.com/cbrew/3710694
-			}
-		}	
-		
-		if (gen%s == 0){			
+
+		if (gen%s == 0){
 			//snapshot name
 			snprintf(fname, 34, "./Snap_folder2/snapshot_%05d.pgm", gen);
-			
-			write_pgm_image( mygrid, 1, xsize, ysize, fname);
+
+			//writing the temporary grid with the new state
+			for (int i=0; i<xsize*ysize; i++){
+				snap_grid[i] = ((next_state & mygrid[i]) == next_state);
+			}
+
+			write_pgm_image( snap_grid, 1, xsize, ysize, fname);
 		}
-	
+
 	}//end iterations on gen
-	
-	if (s == n){			
+
+	if (s == n){
 		//snapshot name
 		snprintf(fname, 34, "./Snap_folder2/snapshot_%05d.pgm", n);
-		
-		write_pgm_image( mygrid, 1, xsize, ysize, fname);
+
+		//writing the temporary grid with the final state
+		for (int i=0; i<xsize*ysize; i++){
+			snap_grid[i] = ((next_state & mygrid[i]) == next_state);
+		}
+
+		write_pgm_image( snap_grid, 1, xsize, ysize, fname);
 	}
-	
+
 	if ( fname != NULL )
 		free(fname);
-	if ( padd_grid != NULL )
-		free(padd_grid);	
+	if ( snap_grid != NULL )
+		free(snap_grid);
 }
 
 // *********************************************************************************************************************************
@@ -797,8 +641,12 @@ int main ( int argc, char **argv )
 	-f: Requires an argument (e.g., -f filename.pgm). 
 	Name of the file to be either read or written
 	-n: Requires an argument (e.g., -n 10000). Number of steps.
-	-s: Requires an argument (e.g., -s 1). Frequency of dump.*/
-	char *optstring = "irk:e:f:n:s:";
+	-s: Requires an argument (e.g., -s 1). Frequency of dump.
+	-v: Requires an argument (e.g., -v avx2). Version of the vectorized kernels (scalar, lut, sse2, avx2, avx512).
+	-R: Requires an argument (e.g., -R B36/S23). Rule of the evolution (default B3/S23).*/
+	char *optstring = "irk:e:f:n:s:v:R:";
+	char *isa = NULL;
+	char *rule = NULL;
 	int maxval = 1;
 	int c;
 	/*When the getopt function is called in the while loop,
@@ -826,7 +674,7 @@ int main ( int argc, char **argv )
 				break;
 
 			case 'f':
-				fname = (char*)malloc( sizeof(optarg)+1 );
+				fname = (char*)malloc( strlen(optarg)+1 );
 				sprintf(fname, "%s", optarg );
 				break;  
 
@@ -838,6 +686,14 @@ int main ( int argc, char **argv )
 				s = atoi(optarg); 
 				break;
 
+			case 'v':
+				isa = optarg;
+				break;
+
+			case 'R':
+				rule = optarg;
+				break;
+
 			default :
 				printf("argument -%c not known\n", c ); 
 				break;
@@ -853,6 +709,13 @@ int main ( int argc, char **argv )
 
 	if (action==RUN){
 		
+		if(rule != NULL && set_rule(rule) != 0){
+			printf("Rule %s not valid, using B3/S23\n", rule);
+		}
+		if(select_static_kernel(isa) != 0){
+			printf("Kernel version %s not available, using %s\n", isa, static_kernel_name());
+		}
+		
 		if(s==0){
 			s=n;  // Here we print only at the end
 		}
@@ -879,10 +742,10 @@ int main ( int argc, char **argv )
 			read_pgm_image((void **)&my_grid_s, &maxval, &k, &k, fname);
 			double t_start = CPU_TIME;
 			
-			if(e = 1){
+			if(e == 1){
 				static_evolution(my_grid_s, k, k, n, s);	//classical static evolution
 			}
-			else if(e = 2){
+			else if(e == 2){
 				static_evolution2(my_grid_s, k, k, n, s);	//modified static evolution with padded grid
 			}
 			else if(e == 3){
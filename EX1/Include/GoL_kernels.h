@@ -0,0 +1,30 @@
+#ifndef GOL_KERNELS
+#define GOL_KERNELS
+
+#include <stdint.h>
+
+// Masks of the common rules (bit n is set if a cell with n neighbours is born / survives)
+#define RULE_CONWAY_BIRTH 0x008     // B3
+#define RULE_CONWAY_SURVIVE 0x00C   // S23
+#define RULE_HIGHLIFE_BIRTH 0x048   // B36
+#define RULE_HIGHLIFE_SURVIVE 0x00C // S23
+#define RULE_DAYNIGHT_BIRTH 0x1C8   // B3678
+#define RULE_DAYNIGHT_SURVIVE 0x1D8 // S34678
+
+// Rule of the evolution (set with set_rule, the default is B3/S23)
+extern unsigned int rule_birth;
+extern unsigned int rule_survive;
+
+// New state (0 or 1) of a cell with the state my_current and nei live neighbours
+#define RULE_NEW_STATE(my_current, nei) ((((my_current) ? rule_survive : rule_birth) >> (nei)) & 1)
+
+int set_rule(const char *rule);
+int select_static_kernel(const char *isa);
+const char * static_kernel_name(void);
+void static_evolve_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next);
+void static_evolve_segment(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next);
+void static_evolve_padded_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next);
+void static_stream_row(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize);
+uint64_t ordered_flip_mask(unsigned char *cells, int count);
+
+#endif
@@ -0,0 +1,287 @@
+// Template of the row kernels of GoL_kernels.c for a Life-like rule. It's included by GoL_kernels.c once for each
+// rule (so there is no include guard). Before including it define:
+//	RULE_SUFFIX    suffix of the names of the kernels (static_row_scalar_<suffix>, static_row_sse2_<suffix>, ...,
+//	               static_row_padded_sse2_<suffix>, ..., static_row_stream_sse2_<suffix>, ...)
+//	RULE_BIRTH     mask of the rule: bit n is set if a dead cell with n neighbours is born
+//	RULE_SURVIVE   mask of the rule: bit n is set if a live cell with n neighbours survives
+//	RULE_LOOKUP    (optional) the avx2 and avx512 kernels find the new state with a table lookup (pshufb)
+//	               instead of comparing the number of neighbours with each value in the masks
+// When the masks are constants the compiler keeps only the comparisons that are really needed
+// (for B3/S23: nei == 3, or nei == 2 and the cell is alive), so each rule gets its own specialised kernels.
+
+#define RULE_CONCAT2(a, b) a##_##b
+#define RULE_CONCAT(a, b) RULE_CONCAT2(a, b)
+#define RULE_KERNEL(isa) RULE_CONCAT(static_row_##isa, RULE_SUFFIX)
+
+static void RULE_KERNEL(scalar)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+
+	// Scalar version, used also for the cells at the borders of the vectorized versions.
+	// The cells of my_row are kept in registers while moving along the row (my_left, my_current, my_right):
+	// reading again the cell on the left after writing it would make each cell wait for the previous one.
+
+	int left;         // position of the cell on the left (x-1, or xsize-1 if x == 0)
+	int right;        // position of the cell on the right (x+1, or 0 if x == xsize-1)
+	unsigned char nei;
+	unsigned char my_left, my_current, my_right;
+
+	if (x_start >= x_end)
+		return;
+	my_left = my_row[x_start - 1 + (xsize * (x_start == 0))] & current;
+	my_current = my_row[x_start] & current;
+
+	for (int x=x_start; x<x_end; x++){
+		left = x - 1 + (xsize * (x == 0));
+		right = x + 1 - (xsize * (x == xsize-1));
+		my_right = my_row[right] & current;
+
+		nei = 0;
+		nei += up_row[left] & current;
+		nei += up_row[x] & current;
+		nei += up_row[right] & current;
+		nei += my_left;
+		nei += my_right;
+		nei += down_row[left] & current;
+		nei += down_row[x] & current;
+		nei += down_row[right] & current;
+		nei >>= (current -1); // rescaling the value of nei (if current = 2 then nei is stored starting from the second bit)
+
+		my_row[x] = my_current + next * rule_scalar(my_current, nei, RULE_BIRTH, RULE_SURVIVE);
+
+		my_left = my_current;
+		my_current = my_right;
+	}
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+__attribute__((target("sse2")))
+static void RULE_KERNEL(sse2)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+
+	// Processes 16 cells at the same time. The neighbours are masked with "current" and summed,
+	// so that the sum is nei*current. The new state is then obtained comparing the sum with the multiples of current.
+
+	__m128i cur = _mm_set1_epi8(current);
+	__m128i nxt = _mm_set1_epi8(next);
+	__m128i sum, mine, alive;
+	int x;
+
+	x = x_start;
+	if (x == 0 && x_end > 0){
+		RULE_KERNEL(scalar)(up_row, my_row, down_row, 0, 1, xsize, current, next);  // first cell (wraps on the left)
+		x = 1;
+	}
+	for (; x+16 < xsize && x+16 <= x_end; x+=16){
+		sum =                   _mm_and_si128(_mm_loadu_si128((__m128i*)(up_row + x - 1)), cur);
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(up_row + x)), cur));
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(up_row + x + 1)), cur));
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(my_row + x - 1)), cur));
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(my_row + x + 1)), cur));
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(down_row + x - 1)), cur));
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(down_row + x)), cur));
+		sum = _mm_add_epi8(sum, _mm_and_si128(_mm_loadu_si128((__m128i*)(down_row + x + 1)), cur));
+
+		mine = _mm_and_si128(_mm_loadu_si128((__m128i*)(my_row + x)), cur);
+		alive = rule_sse2(sum, _mm_cmpeq_epi8(mine, cur), current, RULE_BIRTH, RULE_SURVIVE);
+		_mm_storeu_si128((__m128i*)(my_row + x), _mm_or_si128(mine, _mm_and_si128(alive, nxt)));
+	}
+	RULE_KERNEL(scalar)(up_row, my_row, down_row, x, x_end, xsize, current, next);  // remaining cells (the last one wraps on the right)
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+__attribute__((target("avx2")))
+static void RULE_KERNEL(avx2)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+
+	// Same as the sse2 version, but on 32 cells at the same time
+
+	__m256i cur = _mm256_set1_epi8(current);
+	__m256i nxt = _mm256_set1_epi8(next);
+	__m256i sum, mine, alive;
+#ifdef RULE_LOOKUP
+	__m256i birth_table = rule_table_avx2(RULE_BIRTH);
+	__m256i survive_table = rule_table_avx2(RULE_SURVIVE);
+#endif
+	int x;
+
+	x = x_start;
+	if (x == 0 && x_end > 0){
+		RULE_KERNEL(scalar)(up_row, my_row, down_row, 0, 1, xsize, current, next);  // first cell (wraps on the left)
+		x = 1;
+	}
+	for (; x+32 < xsize && x+32 <= x_end; x+=32){
+		sum =                      _mm256_and_si256(_mm256_loadu_si256((__m256i*)(up_row + x - 1)), cur);
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(up_row + x)), cur));
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(up_row + x + 1)), cur));
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(my_row + x - 1)), cur));
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(my_row + x + 1)), cur));
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(down_row + x - 1)), cur));
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(down_row + x)), cur));
+		sum = _mm256_add_epi8(sum, _mm256_and_si256(_mm256_loadu_si256((__m256i*)(down_row + x + 1)), cur));
+
+		mine = _mm256_and_si256(_mm256_loadu_si256((__m256i*)(my_row + x)), cur);
+#ifdef RULE_LOOKUP
+		alive = rule_lookup_avx2(sum, _mm256_cmpeq_epi8(mine, cur), current, birth_table, survive_table);
+#else
+		alive = rule_avx2(sum, _mm256_cmpeq_epi8(mine, cur), current, RULE_BIRTH, RULE_SURVIVE);
+#endif
+		_mm256_storeu_si256((__m256i*)(my_row + x), _mm256_or_si256(mine, _mm256_and_si256(alive, nxt)));
+	}
+	RULE_KERNEL(scalar)(up_row, my_row, down_row, x, x_end, xsize, current, next);  // remaining cells (the last one wraps on the right)
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+__attribute__((target("avx512f,avx512bw")))
+static void RULE_KERNEL(avx512)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x_start, int x_end, int xsize, unsigned char current, unsigned char next){
+
+	// Same as the sse2 version, but on 64 cells at the same time. The comparisons give bit masks
+	// that are used to select "next" only in the cells that will be alive.
+
+	__m512i cur = _mm512_set1_epi8(current);
+	__m512i nxt = _mm512_set1_epi8(next);
+	__m512i sum, mine;
+	__mmask64 alive;
+#ifdef RULE_LOOKUP
+	__m512i birth_table = rule_table_avx512(RULE_BIRTH);
+	__m512i survive_table = rule_table_avx512(RULE_SURVIVE);
+#endif
+	int x;
+
+	x = x_start;
+	if (x == 0 && x_end > 0){
+		RULE_KERNEL(scalar)(up_row, my_row, down_row, 0, 1, xsize, current, next);  // first cell (wraps on the left)
+		x = 1;
+	}
+	for (; x+64 < xsize && x+64 <= x_end; x+=64){
+		sum =                      _mm512_and_si512(_mm512_loadu_si512((void*)(up_row + x - 1)), cur);
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(up_row + x)), cur));
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(up_row + x + 1)), cur));
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(my_row + x - 1)), cur));
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(my_row + x + 1)), cur));
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(down_row + x - 1)), cur));
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(down_row + x)), cur));
+		sum = _mm512_add_epi8(sum, _mm512_and_si512(_mm512_loadu_si512((void*)(down_row + x + 1)), cur));
+
+		mine = _mm512_and_si512(_mm512_loadu_si512((void*)(my_row + x)), cur);
+#ifdef RULE_LOOKUP
+		alive = rule_lookup_avx512(sum, _mm512_cmpeq_epi8_mask(mine, cur), current, birth_table, survive_table);
+#else
+		alive = rule_avx512(sum, _mm512_cmpeq_epi8_mask(mine, cur), current, RULE_BIRTH, RULE_SURVIVE);
+#endif
+		_mm512_storeu_si512((void*)(my_row + x), _mm512_or_si512(mine, _mm512_maskz_mov_epi8(alive, nxt)));
+	}
+	RULE_KERNEL(scalar)(up_row, my_row, down_row, x, x_end, xsize, current, next);  // remaining cells (the last one wraps on the right)
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+static inline __attribute__((always_inline)) void RULE_KERNEL(padded)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+
+	// Version for the rows of a halo grid (GoL_parallel_grid.c): the ghost columns make x-1 and x+1 valid for every
+	// cell, so there is a single loop without borders and without branches, and it's vectorised by the compiler.
+	// The cells are done in blocks of 64, up to the next multiple of 64 (the padding of the row): the extra cells
+	// only get a meaningless "next" bit, and the "current" bit, the only one that is read, is preserved.
+	// The new values of a block are stored only after the whole block is computed, since the compiler doesn't
+	// vectorise a loop that writes my_row[x] and reads my_row[x-1] in the following iteration.
+
+	unsigned char block[64];
+
+	for (int x0=0; x0<xsize; x0+=64){
+		for (int i=0; i<64; i++){
+			int x = x0 + i;
+			unsigned char sum = (up_row[x-1] & current) + (up_row[x] & current) + (up_row[x+1] & current)
+			                  + (my_row[x-1] & current) + (my_row[x+1] & current)
+			                  + (down_row[x-1] & current) + (down_row[x] & current) + (down_row[x+1] & current);
+			unsigned char mine = my_row[x] & current;
+			block[i] = mine | (next & -rule_compare(sum, mine, current, RULE_BIRTH, RULE_SURVIVE));
+		}
+		memcpy(my_row + x0, block, 64);
+	}
+}
+
+// The padded version compiled for each instruction set
+__attribute__((target("sse2")))
+static void RULE_KERNEL(padded_sse2)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+	RULE_KERNEL(padded)(up_row, my_row, down_row, xsize, current, next);
+}
+
+__attribute__((target("avx2")))
+static void RULE_KERNEL(padded_avx2)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+	RULE_KERNEL(padded)(up_row, my_row, down_row, xsize, current, next);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void RULE_KERNEL(padded_avx512)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int xsize, unsigned char current, unsigned char next){
+	RULE_KERNEL(padded)(up_row, my_row, down_row, xsize, current, next);
+}
+
+// *********************************************************************************************************************************
+
+// *********************************************************************************************************************************
+
+static inline __attribute__((always_inline)) void RULE_KERNEL(stream_block)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, int x0, unsigned char *block){
+
+	// New states of the 64 cells from x0 for the double-buffered version (one state per char, 0 or 1, in rows
+	// of a halo grid), vectorised by the compiler like the padded version
+
+	for (int i=0; i<64; i++){
+		int x = x0 + i;
+		unsigned char sum = up_row[x-1] + up_row[x] + up_row[x+1] + my_row[x-1] + my_row[x+1] + down_row[x-1] + down_row[x] + down_row[x+1];
+		block[i] = rule_compare(sum, my_row[x], 1, RULE_BIRTH, RULE_SURVIVE);
+	}
+}
+
+// Double-buffered version for each instruction set: my_row and the rows around it are only read, and the new states
+// are written in new_row (in the other grid) with non-temporal stores, see stream_store_sse2.
+// The last block of the row is stored normally, since its ghost column is written again just after.
+
+__attribute__((target("sse2")))
+static void RULE_KERNEL(stream_sse2)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize){
+	unsigned char block[64];
+	unsigned char first_cell = 0;
+	for (int x0=0; x0<xsize; x0+=64){
+		RULE_KERNEL(stream_block)(up_row, my_row, down_row, x0, block);
+		first_cell = (x0 == 0) ? block[0] : first_cell;
+		stream_store_sse2(new_row + x0, block, x0 + 64 < xsize);
+	}
+	new_row[-1] = new_row[xsize - 1];
+	new_row[xsize] = first_cell;
+}
+
+__attribute__((target("avx2")))
+static void RULE_KERNEL(stream_avx2)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize){
+	unsigned char block[64];
+	unsigned char first_cell = 0;
+	for (int x0=0; x0<xsize; x0+=64){
+		RULE_KERNEL(stream_block)(up_row, my_row, down_row, x0, block);
+		first_cell = (x0 == 0) ? block[0] : first_cell;
+		stream_store_avx2(new_row + x0, block, x0 + 64 < xsize);
+	}
+	new_row[-1] = new_row[xsize - 1];
+	new_row[xsize] = first_cell;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void RULE_KERNEL(stream_avx512)(unsigned char *up_row, unsigned char *my_row, unsigned char *down_row, unsigned char *new_row, int xsize){
+	unsigned char block[64];
+	unsigned char first_cell = 0;
+	for (int x0=0; x0<xsize; x0+=64){
+		RULE_KERNEL(stream_block)(up_row, my_row, down_row, x0, block);
+		first_cell = (x0 == 0) ? block[0] : first_cell;
+		stream_store_avx512(new_row + x0, block, x0 + 64 < xsize);
+	}
+	new_row[-1] = new_row[xsize - 1];
+	new_row[xsize] = first_cell;
+}
+
+#undef RULE_KERNEL
+#undef RULE_CONCAT
+#undef RULE_CONCAT2
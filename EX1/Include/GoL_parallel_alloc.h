@@ -0,0 +1,10 @@
+#ifndef GOL_PARALLEL_ALLOC
+#define GOL_PARALLEL_ALLOC
+
+#include <stddef.h>
+
+unsigned char * grid_alloc(int rows, size_t row_bytes);
+void grid_free(unsigned char *memory);
+void grid_placement_report(unsigned char *memory, const char *label);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef GOL_PARALLEL_BALANCE
+#define GOL_PARALLEL_BALANCE
+
+// Generations between two balancing steps if the period is not given (-b)
+#define BALANCE_PERIOD 50
+// The rows are moved only if the slowest process is slower than the mean by more than this fraction
+#define BALANCE_TOLERANCE 0.05
+
+void balanced_static_evolution(unsigned char **my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int *my_chunk, int n, int s, int period);
+
+#endif
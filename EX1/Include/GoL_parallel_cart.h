@@ -0,0 +1,6 @@
+#ifndef GOL_PARALLEL_CART
+#define GOL_PARALLEL_CART
+
+void cart_static_evolution(unsigned char *grid, int xsize, int n, int s);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef GOL_PARALLEL_DATAFLOW
+#define GOL_PARALLEL_DATAFLOW
+
+void dataflow_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef GOL_PARALLEL_DEEP_HALO
+#define GOL_PARALLEL_DEEP_HALO
+
+void deep_halo_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int halo_depth);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef GOL_PARALLEL_ENSEMBLE
+#define GOL_PARALLEL_ENSEMBLE
+
+// Probability that a cell of the input board is flipped in each of the other boards of the ensemble
+#define ENSEMBLE_PERTURBATION 0.05
+
+void ensemble_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int n_boards);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef GOL_PARALLEL_GRID
+#define GOL_PARALLEL_GRID
+
+// Portion of the grid of a MPI process, with ghost rows on the top and on the bottom (one, or more for a deep halo)
+// and a ghost column on the left and on the right, all in a single allocation aligned to 64 bytes (see GoL_parallel_grid.c)
+typedef struct {
+	unsigned char *memory;  // the allocation
+	int xsize;              // number of cells in a row
+	int rows;               // number of rows of the process (without the ghost rows)
+	int halo;               // number of ghost rows on each side
+	int stride;             // distance between the beginning of two rows (multiple of 64)
+} halo_grid;
+
+void halo_grid_init(halo_grid *g, int xsize, int rows);
+void halo_grid_init_deep(halo_grid *g, int xsize, int rows, int halo);
+void halo_grid_free(halo_grid *g);
+void halo_grid_load(halo_grid *g, unsigned char *cells);
+void halo_grid_store(halo_grid *g, unsigned char *cells);
+
+// First cell of the row y (from -halo, the first top ghost row, to rows+halo-1, the last bottom ghost row).
+// The ghost columns are in row[-1] and row[xsize]
+static inline unsigned char * halo_row(halo_grid *g, int y){
+	return g->memory + (long int)(y + g->halo) * g->stride + 64;
+}
+
+// Copies the last and the first cell of the row in the ghost columns (the wrap of the torus)
+static inline void halo_fill_columns(unsigned char *row, int xsize){
+	row[-1] = row[xsize - 1];
+	row[xsize] = row[0];
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef GOL_PARALLEL_HALO
+#define GOL_PARALLEL_HALO
+
+#include "mpi.h"
+#include "GoL_parallel_grid.h"
+
+// Boundary rows of halo_exchange_start_row and halo_exchange_finish_row
+#define HALO_FIRST_ROW 0
+#define HALO_LAST_ROW 1
+
+// Exchange of the ghost rows of one halo grid (the in-place static evolution) or of two (the double-buffered one) with
+// the process above and the one below. The exchange is done by one of the backends (see GoL_parallel_halo.c), chosen with select_halo_backend.
+// It can be done as a whole (halo_exchange_start/finish) or a boundary row at a time (halo_exchange_start_row/finish_row).
+typedef struct {
+	int backend;                    // index of the backend
+	halo_grid *grids;               // the grids (one or two)
+	int n_grids;
+	int top_neighbour, bottom_neighbour;
+	int top_rows;                   // rows of the process above (for the one-sided backend)
+	int current[2];                 // grid of the exchange in progress of the first and of the last row (-1 if there is none)
+	MPI_Request requests[2][4];     // point-to-point and persistent backends (one set for each grid)
+	MPI_Comm graph;                 // neighbourhood collective backend
+	MPI_Win windows[2];             // one-sided backend
+	MPI_Group group;
+	double time;                    // time spent in the exchanges
+	int exchanges;                  // number of exchanges
+} halo_exchange;
+
+int select_halo_backend(const char *name);
+const char * halo_backend_name(void);
+void halo_exchange_init(halo_exchange *h, halo_grid *grids, int n_grids, int top_neighbour, int bottom_neighbour, int top_rows);
+void halo_exchange_start(halo_exchange *h, int grid);
+void halo_exchange_finish(halo_exchange *h);
+void halo_exchange_start_row(halo_exchange *h, int grid, int row);
+void halo_exchange_finish_row(halo_exchange *h, int row);
+void halo_exchange_free(halo_exchange *h);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef GOL_PARALLEL_HASHLIFE
+#define GOL_PARALLEL_HASHLIFE
+
+void hashlife_evolution(unsigned char *grid, int xsize, int n, int s);
+
+#endif
@@ -4,7 +4,14 @@
 char *  init_playground(unsigned long int n_cells);
 void static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
 void ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+int l_ind_point(unsigned char val);
 int l_ind(unsigned char *my_grid, int y, int xsize, int stride, int *l_ind_pos, int *l_ind_dist);
+// Steps of ordered_evolution, shared with the other ordered engines
+void ordered_encode(unsigned char *my_grid, int xsize, int my_chunk, unsigned char *top_ghost_row, unsigned char *bottom_ghost_row);
+void ordered_first_row(unsigned char *my_grid, unsigned char *top_ghost_row, int xsize);
+void ordered_fragment(unsigned char *my_grid, int y, int xsize, int start, int dist, int first);
+void ordered_fix_fragments(unsigned char *my_grid, int y, int xsize, int count, int *l_ind_pos, int *l_ind_dist);
+void ordered_last_row(unsigned char *my_grid, unsigned char *bottom_ghost_row, int xsize, int my_chunk);
 int sanity_check_ordered(unsigned char *my_grid, int xsize, int my_chunk, unsigned char *top_ghost_row, unsigned char *bottom_ghost_row);
 
 #endif
@@ -0,0 +1,6 @@
+#ifndef GOL_PARALLEL_INTERIOR_FIRST
+#define GOL_PARALLEL_INTERIOR_FIRST
+
+void interior_first_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+
+#endif
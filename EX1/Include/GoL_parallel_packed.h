@@ -0,0 +1,13 @@
+#ifndef GOL_PARALLEL_PACKED
+#define GOL_PARALLEL_PACKED
+
+#include <stdint.h>
+
+void pack_row(unsigned char *row, uint64_t *packed_row, int xsize);
+void unpack_row(uint64_t *packed_row, unsigned char *row, int xsize);
+void packed_evolve_row(uint64_t *up_row, uint64_t *my_row, uint64_t *down_row, uint64_t *new_row, int xsize);
+void packed_ordered_row(uint64_t *up_row, uint64_t *my_row, uint64_t *down_row, int xsize);
+void packed_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+void packed_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+
+#endif
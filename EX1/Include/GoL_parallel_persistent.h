@@ -0,0 +1,7 @@
+#ifndef GOL_PARALLEL_PERSISTENT
+#define GOL_PARALLEL_PERSISTENT
+
+void persistent_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+void persistent_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef GOL_PARALLEL_SPECULATIVE
+#define GOL_PARALLEL_SPECULATIVE
+
+void speculative_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef GOL_PARALLEL_TEMPORAL
+#define GOL_PARALLEL_TEMPORAL
+
+// Generations advanced by each wave of tiles if the depth is not given (-H)
+#define TEMPORAL_DEPTH 8
+
+void temporal_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int depth);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef GOL_PARALLEL_TILES
+#define GOL_PARALLEL_TILES
+
+void tile_static_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int tile);
+void tile_ordered_evolution(unsigned char *my_grid, unsigned char *grid, int *num_cells, int *displs, int xsize, int my_chunk, int n, int s, int tile);
+
+#endif